@@ -1,24 +1,73 @@
 #include <iostream>
 #include <cstring>
 #include "AsyncFrame.h"
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// 当前线程已消耗的 CPU 周期数
+static U64 threadCpuCycles() {
+#ifdef _WIN32
+    ULONG64 cycles = 0;
+    QueryThreadCycleTime(GetCurrentThread(), &cycles);
+    return cycles;
+#else
+    return 0;
+#endif
+}
 
 
 
 // 构造函数
-AsyncFrameDispatcher::AsyncFrameDispatcher()
+AsyncFrameDispatcher::AsyncFrameDispatcher(std::shared_ptr<WorkerPool> workerPool)
     : m_queueHead(0),
       m_queueTail(0),
-      m_running(false) {
+      m_handlerTable(nullptr),
+      m_tableReaders(0),
+      m_tablesRetired(false),
+      m_overloaded(false),
+      m_maxQueueDepth(0),
+      m_droppedFrames(0),
+      m_overloadEvents(0),
+      m_handlerBudgetNs(0),
+      m_isolateAfter(0),
+      m_running(false),
+      m_nextHandleId(1),
+      m_workerPool(std::move(workerPool)),
+      m_drainScheduled(false),
+      m_drainBuffer(MAX_CMD_LEN),
+      m_waiterCount(0),
+      m_nextWaiterId(1),
+      m_waiterTimerNs(0) {
     // 预分配队列空间
     m_frameQueue.resize(FRAME_QUEUE_SIZE);
-    for (auto& frame : m_frameQueue) {
-        frame.resize(MAX_CMD_LEN);
+    for (auto& slot : m_frameQueue) {
+        slot.data.resize(MAX_CMD_LEN);
+        slot.len = 0;
+        slot.conflateType = 0;
+    }
+    // 初始化合并槽位
+    m_dispatchModes.fill(DispatchMode::QUEUED);
+    m_conflateSubTypes.fill(-1);
+    m_conflateSlots.resize(MAX_FRAME_TYPE);
+    for (auto& slot : m_conflateSlots) {
+        slot.len = 0;
+        slot.pending = false;
+    }
+    for (auto& count : m_conflatedCounts) {
+        count.store(0, std::memory_order_relaxed);
     }
     // 初始化处理函数表
-    m_frameHandlers.resize(MAX_FRAME_TYPE);
+    std::lock_guard<std::mutex> guard(m_handlerMutex);
+    publishEmptyTable();
 }
 
-// 获取单例实例
+// 析构函数
+AsyncFrameDispatcher::~AsyncFrameDispatcher() {
+    uninit();
+}
+
+// 获取默认实例
 AsyncFrameDispatcher& AsyncFrameDispatcher::getInstance() {
     static AsyncFrameDispatcher instance;
     return instance;
@@ -27,12 +76,20 @@ AsyncFrameDispatcher& AsyncFrameDispatcher::getInstance() {
 // 初始化
 void AsyncFrameDispatcher::init() {
     if (!m_running) {
-        m_running = true;
-        m_queueHead = m_queueTail = 0;
-        // 清空回调函数表
-        std::fill(m_frameHandlers.begin(), m_frameHandlers.end(), nullptr);
-        // 创建处理线程
-        m_processThread = std::thread(&AsyncFrameDispatcher::processThreadFunc, this);
+        {
+            std::lock_guard<std::mutex> guard(m_queueMutex);
+            m_running = true;
+            m_queueHead = m_queueTail = 0;
+            m_overloaded = false;
+            for (auto& slot : m_conflateSlots) {
+                slot.pending = false;
+            }
+        }
+        // 保留 init() 之前注册的处理函数和回调（uninit() 时已清空）
+        // 未使用共享线程池时创建独立处理线程
+        if (!m_workerPool) {
+            m_processThread = std::thread(&AsyncFrameDispatcher::processThreadFunc, this);
+        }
         std::cout << "=== Async Frame Dispatcher Init ===" << std::endl;
     }
 }
@@ -40,64 +97,545 @@ void AsyncFrameDispatcher::init() {
 // 反初始化
 void AsyncFrameDispatcher::uninit() {
     if (m_running) {
-        m_running = false;
-        m_frameCondition.notify_one(); // 唤醒线程退出
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_running = false;
+            // 等待线程池中的处理任务结束
+            m_frameCondition.wait(lock, [this] { return !m_drainScheduled; });
+        }
+        m_frameCondition.notify_all(); // 唤醒线程退出
         
         if (m_processThread.joinable()) {
             m_processThread.join();
         }
         
         m_queueHead = m_queueTail = 0;
-        // 清空回调函数表
-        std::fill(m_frameHandlers.begin(), m_frameHandlers.end(), nullptr);
+        // 以空帧结束未完成的等待，处理线程已退出，不会再有帧到达；等待中的协程随之恢复，协程帧得以释放
+        std::vector<FrameWaitCallback> pending;
+        {
+            std::lock_guard<std::mutex> guard(m_waiterMutex);
+            for (auto& waiter : m_waiters) {
+                pending.push_back(std::move(waiter.callback));
+            }
+            m_waiters.clear();
+            m_waiterCount.store(0, std::memory_order_release);
+            m_waiterTimerNs = 0;
+        }
+        failWaiters(pending);
+        // 清空回调函数表，回收旧快照（I/O 线程仍在分发时留给其离开时回收）
+        {
+            std::lock_guard<std::mutex> guard(m_handlerMutex);
+            publishEmptyTable();
+            reclaimHandlerTables();
+        }
         
         std::cout << "=== Async Frame Dispatcher Deinit ===" << std::endl;
     }
 }
 
-// 注册帧处理函数
-void AsyncFrameDispatcher::registerFrameHandler(U8 frameType, std::function<S32(const std::vector<U8>&, U32)> handler) {
-    if (frameType < MAX_FRAME_TYPE) {
-        std::lock_guard<std::mutex> guard(m_handlerMutex);
-        m_frameHandlers[frameType] = std::move(handler);
+// 读端区间：读端计数与快照指针均按顺序一致读写，写端在发布新快照后看到计数为 0 时，
+// 之后进入的读端只能取得新快照，旧快照可以释放
+class AsyncFrameDispatcher::TableReader {
+private:
+    AsyncFrameDispatcher& m_owner;
+
+public:
+    const FrameHandlerTable* table;
+
+    explicit TableReader(AsyncFrameDispatcher& owner) : m_owner(owner) {
+        m_owner.m_tableReaders.fetch_add(1, std::memory_order_seq_cst);
+        table = m_owner.m_handlerTable.load(std::memory_order_seq_cst);
+    }
+
+    ~TableReader() {
+        if (m_owner.m_tableReaders.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+            m_owner.m_tablesRetired.load(std::memory_order_relaxed)) {
+            // 最后一个读端离开时回收；写端正持有锁时由其回收
+            std::unique_lock<std::mutex> lock(m_owner.m_handlerMutex, std::try_to_lock);
+            if (lock.owns_lock()) {
+                m_owner.reclaimHandlerTables();
+            }
+        }
     }
+
+    TableReader(const TableReader&) = delete;
+    TableReader& operator=(const TableReader&) = delete;
+};
+
+// 复制当前快照，修改后发布新快照
+void AsyncFrameDispatcher::publishTable(const std::function<void(FrameHandlerTable&)>& modifier) {
+    const FrameHandlerTable* current = m_handlerTable.load(std::memory_order_relaxed);
+    std::unique_ptr<FrameHandlerTable> table(new FrameHandlerTable(*current));
+    modifier(*table);
+    m_handlerTable.store(table.get(), std::memory_order_seq_cst);
+    m_handlerTables.push_back(std::move(table));
+    // 旧快照可能仍被读端引用，没有读端时立即释放
+    m_tablesRetired.store(true, std::memory_order_relaxed);
+    reclaimHandlerTables();
+}
+
+// 复制当前快照并修改指定表项，然后发布新快照
+void AsyncFrameDispatcher::publishHandler(U8 frameType, FrameHandler handler) {
+    publishTable([&](FrameHandlerTable& table) {
+        table.handlers[frameType] = std::move(handler);
+    });
+}
+
+// 发布空表
+void AsyncFrameDispatcher::publishEmptyTable() {
+    std::unique_ptr<FrameHandlerTable> table(new FrameHandlerTable());
+    m_handlerTable.store(table.get(), std::memory_order_seq_cst);
+    m_handlerTables.push_back(std::move(table));
+    m_tablesRetired.store(true, std::memory_order_relaxed);
+}
+
+// 回收旧快照，只保留当前快照
+void AsyncFrameDispatcher::reclaimHandlerTables() {
+    if (m_tableReaders.load(std::memory_order_seq_cst) != 0) {
+        return; // 仍有读端，由最后离开的读端回收
+    }
+    m_tablesRetired.store(false, std::memory_order_relaxed);
+    const FrameHandlerTable* current = m_handlerTable.load(std::memory_order_relaxed);
+    std::unique_ptr<FrameHandlerTable> keep;
+    for (auto& table : m_handlerTables) {
+        if (table.get() == current) {
+            keep = std::move(table);
+        }
+    }
+    m_handlerTables.clear();
+    m_handlerTables.push_back(std::move(keep));
+}
+
+// 注册帧处理函数
+void AsyncFrameDispatcher::registerFrameHandler(U8 frameType, FrameHandler handler) {
+    std::lock_guard<std::mutex> guard(m_handlerMutex);
+    publishHandler(frameType, std::move(handler));
 }
 
 // 注销帧处理函数
 void AsyncFrameDispatcher::unregisterFrameHandler(U8 frameType) {
-    if (frameType < MAX_FRAME_TYPE) {
-        std::lock_guard<std::mutex> guard(m_handlerMutex);
-        m_frameHandlers[frameType] = nullptr;
+    std::lock_guard<std::mutex> guard(m_handlerMutex);
+    publishHandler(frameType, nullptr);
+}
+
+// 订阅帧
+U32 AsyncFrameDispatcher::subscribe(U8 frameType, FrameHandler handler, FrameFilter filter, bool async) {
+    if (!handler) {
+        return 0;
+    }
+    auto subscriber = std::make_shared<FrameSubscriber>();
+    subscriber->handler = std::move(handler);
+    subscriber->filter = std::move(filter);
+    if (async) {
+        subscriber->executor = std::make_shared<SerialExecutor>();
+    }
+
+    std::lock_guard<std::mutex> guard(m_handlerMutex);
+    subscriber->id = m_nextHandleId++;
+    publishTable([&](FrameHandlerTable& table) {
+        table.subscribers[frameType].push_back(subscriber);
+    });
+    return subscriber->id;
+}
+
+// 取消订阅
+void AsyncFrameDispatcher::unsubscribe(U32 subscriptionId) {
+    std::lock_guard<std::mutex> guard(m_handlerMutex);
+    publishTable([&](FrameHandlerTable& table) {
+        for (auto& subscribers : table.subscribers) {
+            for (auto it = subscribers.begin(); it != subscribers.end(); ++it) {
+                if ((*it)->id == subscriptionId) {
+                    subscribers.erase(it);
+                    return;
+                }
+            }
+        }
+    });
+}
+
+// 添加分发前中间件
+U32 AsyncFrameDispatcher::addMiddleware(FrameMiddleware middleware) {
+    if (!middleware) {
+        return 0;
     }
+    std::lock_guard<std::mutex> guard(m_handlerMutex);
+    U32 id = m_nextHandleId++;
+    publishTable([&](FrameHandlerTable& table) {
+        table.middlewares.push_back({id, std::move(middleware)});
+    });
+    return id;
+}
+
+// 移除分发前中间件
+void AsyncFrameDispatcher::removeMiddleware(U32 middlewareId) {
+    std::lock_guard<std::mutex> guard(m_handlerMutex);
+    publishTable([&](FrameHandlerTable& table) {
+        for (auto it = table.middlewares.begin(); it != table.middlewares.end(); ++it) {
+            if (it->id == middlewareId) {
+                table.middlewares.erase(it);
+                return;
+            }
+        }
+    });
+}
+
+// 等待下一帧匹配的帧
+U32 AsyncFrameDispatcher::waitFrame(U8 frameType, FrameFilter match, FrameWaitCallback callback, U32 timeoutMs) {
+    if (!callback) {
+        return 0;
+    }
+    WaiterTimer timer;
+    U64 timerNs = 0;
+    U32 id;
+    {
+        std::lock_guard<std::mutex> guard(m_waiterMutex);
+        id = m_nextWaiterId++;
+        U64 deadlineNs = timeoutMs > 0 ? monotonicNowNs() + static_cast<U64>(timeoutMs) * 1000000 : 0;
+        m_waiters.push_back({id, frameType, std::move(match), std::move(callback), deadlineNs});
+        m_waiterCount.store(static_cast<U32>(m_waiters.size()), std::memory_order_release);
+        if (deadlineNs != 0) {
+            timerNs = armWaiterTimerLocked();
+            timer = m_waiterTimer;
+        }
+    }
+    if (timerNs != 0 && timer) {
+        timer(timerNs);
+    }
+    return id;
+}
+
+// 取消等待
+bool AsyncFrameDispatcher::cancelWait(U32 waitId) {
+    std::vector<FrameWaitCallback> cancelled;
+    {
+        std::lock_guard<std::mutex> guard(m_waiterMutex);
+        for (auto it = m_waiters.begin(); it != m_waiters.end(); ++it) {
+            if (it->id == waitId) {
+                cancelled.push_back(std::move(it->callback));
+                m_waiters.erase(it);
+                m_waiterCount.store(static_cast<U32>(m_waiters.size()), std::memory_order_release);
+                break;
+            }
+        }
+    }
+    failWaiters(cancelled);
+    return !cancelled.empty();
+}
+
+// 设置等待超时定时器
+void AsyncFrameDispatcher::setWaiterTimer(WaiterTimer timer) {
+    U64 timerNs;
+    {
+        std::lock_guard<std::mutex> guard(m_waiterMutex);
+        m_waiterTimer = std::move(timer);
+        m_waiterTimerNs = 0;
+        timerNs = armWaiterTimerLocked();
+        timer = m_waiterTimer;
+    }
+    if (timerNs != 0 && timer) {
+        timer(timerNs);
+    }
+}
+
+// 以空帧唤醒超时的等待者
+U32 AsyncFrameDispatcher::expireWaiters(U64 nowNs) {
+    std::vector<FrameWaitCallback> expired;
+    WaiterTimer timer;
+    U64 timerNs;
+    {
+        std::lock_guard<std::mutex> guard(m_waiterMutex);
+        for (auto it = m_waiters.begin(); it != m_waiters.end();) {
+            if (it->deadlineNs != 0 && it->deadlineNs <= nowNs) {
+                expired.push_back(std::move(it->callback));
+                it = m_waiters.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        m_waiterCount.store(static_cast<U32>(m_waiters.size()), std::memory_order_release);
+        // 定时器已触发，按剩余等待者中最早的超时时间重新登记
+        m_waiterTimerNs = 0;
+        timerNs = armWaiterTimerLocked();
+        timer = m_waiterTimer;
+    }
+    if (timerNs != 0 && timer) {
+        timer(timerNs);
+    }
+    failWaiters(expired);
+    return static_cast<U32>(expired.size());
+}
+
+// 按最早的超时时间登记定时器，已登记的时间不晚于它时无需重新登记
+U64 AsyncFrameDispatcher::armWaiterTimerLocked() {
+    U64 earliest = 0;
+    for (const auto& waiter : m_waiters) {
+        if (waiter.deadlineNs != 0 && (earliest == 0 || waiter.deadlineNs < earliest)) {
+            earliest = waiter.deadlineNs;
+        }
+    }
+    if (earliest == 0 || !m_waiterTimer || (m_waiterTimerNs != 0 && m_waiterTimerNs <= earliest)) {
+        return 0;
+    }
+    m_waiterTimerNs = earliest;
+    return earliest;
+}
+
+// 以空帧调用等待者回调
+void AsyncFrameDispatcher::failWaiters(std::vector<FrameWaitCallback>& callbacks) {
+    static const std::vector<U8> empty;
+    for (auto& callback : callbacks) {
+        try {
+            callback(empty, 0);
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in frame waiter: " << e.what() << std::endl;
+        }
+    }
+}
+
+// 设置协程默认恢复调度器
+void AsyncFrameDispatcher::setResumeScheduler(ResumeScheduler scheduler) {
+    std::lock_guard<std::mutex> guard(m_waiterMutex);
+    m_resumeScheduler = std::move(scheduler);
+}
+
+// 获取协程默认恢复调度器
+ResumeScheduler AsyncFrameDispatcher::getResumeScheduler() {
+    std::lock_guard<std::mutex> guard(m_waiterMutex);
+    return m_resumeScheduler;
+}
+
+// 取出与该帧匹配的一次性等待者
+bool AsyncFrameDispatcher::takeWaiters(const std::vector<U8>& frame, U32 len, std::vector<FrameWaitCallback>& matched) {
+    std::lock_guard<std::mutex> guard(m_waiterMutex);
+    for (auto it = m_waiters.begin(); it != m_waiters.end();) {
+        if (it->frameType == frame[0] && (!it->match || it->match(frame, len))) {
+            matched.push_back(std::move(it->callback));
+            it = m_waiters.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_waiterCount.store(static_cast<U32>(m_waiters.size()), std::memory_order_release);
+    return !matched.empty();
+}
+
+// 调用取出的等待者回调：解锁后调用，回调中可以再次等待（协程恢复后继续 co_await）
+void AsyncFrameDispatcher::callWaiters(std::vector<FrameWaitCallback>& matched, const std::vector<U8>& frame, U32 len) {
+    for (auto& callback : matched) {
+        try {
+            callback(frame, len);
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in frame waiter for type 0x" 
+                      << std::hex << static_cast<int>(frame[0]) 
+                      << std::dec << ": " << e.what() << std::endl;
+        }
+    }
+}
+
+// 当前分发中的帧的时间戳
+static thread_local const FrameTiming* t_currentTiming = nullptr;
+
+// 在执行器中调用处理函数期间设置当前帧的时间戳，退出（含异常）时恢复
+class CurrentTimingScope {
+private:
+    const FrameTiming* m_outer;
+
+public:
+    explicit CurrentTimingScope(const FrameTiming& timing) : m_outer(t_currentTiming) {
+        t_currentTiming = &timing;
+    }
+    ~CurrentTimingScope() { t_currentTiming = m_outer; }
+};
+
+const FrameTiming& AsyncFrameDispatcher::currentTiming() {
+    static const FrameTiming empty;
+    return t_currentTiming ? *t_currentTiming : empty;
+}
+
+// 记录入队时间并填写主机对齐时间
+FrameTiming AsyncFrameDispatcher::stampTiming(const std::vector<U8>& frame, U32 len, const FrameTiming& timing) {
+    FrameTiming stamped = timing;
+    stamped.enqueueTime = monotonicNowNs();
+    TableReader reader(*this);
+    if (reader.table && reader.table->frameClock) {
+        stamped.alignedTime = reader.table->frameClock(frame, len, stamped);
+    }
+    return stamped;
 }
 
 // 将一帧放入队列
-S32 AsyncFrameDispatcher::pushFrameToQueue(const std::vector<U8>& frame, U32 len) {
+S32 AsyncFrameDispatcher::pushFrameToQueue(const std::vector<U8>& frame, U32 len, const FrameTiming& timing) {
     if (frame.empty() || len <= 0 || len > MAX_CMD_LEN) {
         return -1;
     }
     
-    std::lock_guard<std::mutex> guard(m_queueMutex);
+    FrameTiming stamped = stampTiming(frame, len, timing);
+    
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    U8 frameType = frame[0];
+    if (m_dispatchModes[frameType] == DispatchMode::INLINE) {
+        // 直接分发，不经过队列，也不唤醒处理线程
+        lock.unlock();
+        if (m_running) {
+            dispatchFrame(frame, len, stamped);
+        }
+        return 0;
+    }
+    bool conflate = m_dispatchModes[frameType] == DispatchMode::CONFLATED &&
+                    (m_conflateSubTypes[frameType] < 0 ||
+                     (len > 1 && frame[1] == m_conflateSubTypes[frameType]));
+    ConflateSlot& conflateSlot = m_conflateSlots[frameType];
+    
+    if (conflate && conflateSlot.pending) {
+        // 已有同类帧等待处理，直接覆盖为最新值
+        std::memcpy(conflateSlot.data.data(), frame.data(), len);
+        conflateSlot.len = len;
+        conflateSlot.timing = stamped;
+        m_conflatedCounts[frameType].fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    
     U32 nextTail = (m_queueTail + 1) % FRAME_QUEUE_SIZE;
+    bool overloadChanged = false;
     
     if (nextTail != m_queueHead) {
-        // 队列不满，放入数据
-        if (m_frameQueue[m_queueTail].size() < len) {
-            m_frameQueue[m_queueTail].resize(len);
+        FrameSlot& slot = m_frameQueue[m_queueTail];
+        if (conflate) {
+            // 数据存入合并槽位，队列中只放标记
+            if (conflateSlot.data.size() < MAX_CMD_LEN) {
+                conflateSlot.data.resize(MAX_CMD_LEN);
+            }
+            std::memcpy(conflateSlot.data.data(), frame.data(), len);
+            conflateSlot.len = len;
+            conflateSlot.timing = stamped;
+            conflateSlot.pending = true;
+            slot.len = 0;
+            slot.conflateType = frameType;
+        } else {
+            // 队列不满，放入数据
+            if (slot.data.size() < len) {
+                slot.data.resize(len);
+            }
+            std::memcpy(slot.data.data(), frame.data(), len);
+            slot.len = len;
+            slot.timing = stamped;
         }
-        std::memcpy(m_frameQueue[m_queueTail].data(), frame.data(), len);
         m_queueTail = nextTail;
-        m_frameCondition.notify_one(); // 通知处理线程
-        return 0;
+        overloadChanged = updateOverloadLocked();
+        if (m_workerPool) {
+            scheduleDrainLocked(); // 提交到共享线程池
+        } else {
+            m_frameCondition.notify_one(); // 通知处理线程
+        }
     } else {
-        // 队列已满
-        std::cerr << "Frame queue full, dropping frame!" << std::endl;
+        // 队列已满，只计数不打印，避免在过载时阻塞 I/O 线程
+        m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
         return -2;
     }
+    
+    if (overloadChanged) {
+        lock.unlock();
+        notifyOverload(true);
+    }
+    return 0;
+}
+
+// 在调用线程中直接分发一帧
+S32 AsyncFrameDispatcher::dispatchInline(const std::vector<U8>& frame, U32 len, const FrameTiming& timing) {
+    if (frame.empty() || len <= 0 || len > MAX_CMD_LEN || !m_running) {
+        return -1;
+    }
+    FrameTiming stamped = stampTiming(frame, len, timing);
+    dispatchFrame(frame, len, stamped);
+    return 0;
+}
+
+// 队列深度
+U32 AsyncFrameDispatcher::queueDepthLocked() const {
+    return (m_queueTail + FRAME_QUEUE_SIZE - m_queueHead) % FRAME_QUEUE_SIZE;
+}
+
+// 按队列深度更新过载状态（高低水位滞回，避免频繁切换）
+bool AsyncFrameDispatcher::updateOverloadLocked() {
+    U32 depth = queueDepthLocked();
+    if (depth > m_maxQueueDepth.load(std::memory_order_relaxed)) {
+        m_maxQueueDepth.store(depth, std::memory_order_relaxed);
+    }
+    bool overloaded = m_overloaded.load(std::memory_order_relaxed);
+    if (!overloaded && depth >= FRAME_QUEUE_HIGH_WATER) {
+        m_overloaded.store(true, std::memory_order_release);
+        m_overloadEvents.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    if (overloaded && depth <= FRAME_QUEUE_LOW_WATER) {
+        m_overloaded.store(false, std::memory_order_release);
+        return true;
+    }
+    return false;
+}
+
+// 通知过载状态变化
+void AsyncFrameDispatcher::notifyOverload(bool overloaded) {
+    TableReader reader(*this);
+    if (reader.table->overloadCallback) {
+        reader.table->overloadCallback(overloaded);
+    }
+}
+
+// 设置过载事件回调
+void AsyncFrameDispatcher::setOverloadCallback(OverloadCallback callback) {
+    std::lock_guard<std::mutex> guard(m_handlerMutex);
+    publishTable([&](FrameHandlerTable& table) {
+        table.overloadCallback = std::move(callback);
+    });
+}
+
+// 设置帧时钟函数
+void AsyncFrameDispatcher::setFrameClock(FrameClock clock) {
+    std::lock_guard<std::mutex> guard(m_handlerMutex);
+    publishTable([&](FrameHandlerTable& table) {
+        table.frameClock = std::move(clock);
+    });
+}
+
+// 获取运行统计
+DispatcherStats AsyncFrameDispatcher::getStats() {
+    DispatcherStats stats;
+    {
+        std::lock_guard<std::mutex> guard(m_queueMutex);
+        stats.queueDepth = queueDepthLocked();
+    }
+    stats.maxQueueDepth = m_maxQueueDepth.load(std::memory_order_relaxed);
+    stats.droppedFrames = m_droppedFrames.load(std::memory_order_relaxed);
+    stats.overloadEvents = m_overloadEvents.load(std::memory_order_relaxed);
+    stats.overloaded = m_overloaded.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// 设置帧分发模式
+void AsyncFrameDispatcher::setDispatchMode(U8 frameType, DispatchMode mode, S32 subType) {
+    std::lock_guard<std::mutex> guard(m_queueMutex);
+    m_dispatchModes[frameType] = mode;
+    m_conflateSubTypes[frameType] = subType;
+}
+
+// 获取某类帧被合并（覆盖）的次数
+U32 AsyncFrameDispatcher::getConflatedCount(U8 frameType) const {
+    return m_conflatedCounts[frameType].load(std::memory_order_relaxed);
+}
+
+// 获取所有帧被合并（覆盖）的总次数
+U32 AsyncFrameDispatcher::getTotalConflatedCount() const {
+    U32 total = 0;
+    for (const auto& count : m_conflatedCounts) {
+        total += count.load(std::memory_order_relaxed);
+    }
+    return total;
 }
 
 // 处理线程函数
 void AsyncFrameDispatcher::processThreadFunc() {
+    std::vector<U8> frame(MAX_CMD_LEN); // 处理线程本地缓冲区，与队列槽位轮换使用
     while (m_running) {
         std::unique_lock<std::mutex> lock(m_queueMutex);
         // 等待有新帧或停止信号
@@ -111,47 +649,255 @@ void AsyncFrameDispatcher::processThreadFunc() {
         }
         
         // 处理队列中的所有帧
-        while (m_queueHead != m_queueTail) {
-            // 创建副本，避免长时间占用锁
-            std::vector<U8> frame = m_frameQueue[m_queueHead];
-            U32 len = frame.size();
-            m_queueHead = (m_queueHead + 1) % FRAME_QUEUE_SIZE;
-            lock.unlock(); // 处理帧前解锁
-            
-            dispatchFrame(frame, len);
-            
-            lock.lock(); // 重新获取锁，检查队列是否还有数据
+        drainFramesLocked(lock, frame, FRAME_QUEUE_SIZE);
+    }
+}
+
+// 处理队列中最多 maxFrames 帧
+void AsyncFrameDispatcher::drainFramesLocked(std::unique_lock<std::mutex>& lock, std::vector<U8>& frame, U32 maxFrames) {
+    U32 count = 0;
+    while (m_queueHead != m_queueTail && count++ < maxFrames) {
+        // 与槽位交换缓冲区，避免长时间占用锁，也避免每帧分配内存
+        FrameSlot& slot = m_frameQueue[m_queueHead];
+        U32 len = slot.len;
+        FrameTiming timing;
+        if (len == 0) {
+            // 合并槽位标记，取出该类型的最新一帧
+            ConflateSlot& conflateSlot = m_conflateSlots[slot.conflateType];
+            len = conflateSlot.len;
+            timing = conflateSlot.timing;
+            frame.swap(conflateSlot.data);
+            conflateSlot.pending = false;
+        } else {
+            timing = slot.timing;
+            frame.swap(slot.data);
+        }
+        m_queueHead = (m_queueHead + 1) % FRAME_QUEUE_SIZE;
+        bool overloadChanged = m_overloaded.load(std::memory_order_relaxed) && updateOverloadLocked();
+        lock.unlock(); // 处理帧前解锁
+        
+        if (overloadChanged) {
+            notifyOverload(false); // 恢复接收许可
+        }
+        dispatchFrame(frame, len, timing);
+        
+        lock.lock(); // 重新获取锁，检查队列是否还有数据
+    }
+}
+
+// 向线程池提交处理任务，同一设备同一时刻只有一个处理任务，保证帧顺序
+void AsyncFrameDispatcher::scheduleDrainLocked() {
+    if (!m_drainScheduled && m_running) {
+        m_drainScheduled = true;
+        m_workerPool->post([this]() { drainQueue(); });
+    }
+}
+
+// 线程池处理任务
+void AsyncFrameDispatcher::drainQueue() {
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    drainFramesLocked(lock, m_drainBuffer, FRAME_DRAIN_BATCH);
+    m_drainScheduled = false;
+    if (m_queueHead != m_queueTail) {
+        // 还有剩余帧，重新排队，让其他设备的任务先执行
+        scheduleDrainLocked();
+    }
+    if (!m_drainScheduled) {
+        m_frameCondition.notify_all(); // 通知可能在等待的 uninit
+    }
+}
+
+// 调用主处理函数并统计执行时间
+void AsyncFrameDispatcher::invokeHandler(const FrameHandlerTable& table, U8 frameType, const FrameHandler& handler,
+                                         const std::vector<U8>& frame, U32 len) {
+    U64 startNs = monotonicNowNs();
+    U64 startCycles = threadCpuCycles();
+    try {
+        handler(frame, len);
+    } catch (const std::exception& e) {
+        std::cerr << "Exception in frame handler for type 0x" 
+                  << std::hex << static_cast<int>(frameType) 
+                  << std::dec << ": " << e.what() << std::endl;
+    }
+    U64 durationNs = monotonicNowNs() - startNs;
+    
+    HandlerAccount& account = m_handlerAccounts[frameType];
+    account.invocations.fetch_add(1, std::memory_order_relaxed);
+    account.totalNs.fetch_add(durationNs, std::memory_order_relaxed);
+    account.cpuCycles.fetch_add(threadCpuCycles() - startCycles, std::memory_order_relaxed);
+    U64 maxNs = account.maxNs.load(std::memory_order_relaxed);
+    while (durationNs > maxNs && !account.maxNs.compare_exchange_weak(maxNs, durationNs, std::memory_order_relaxed)) {
+    }
+    
+    U64 budgetNs = m_handlerBudgetNs.load(std::memory_order_relaxed);
+    if (budgetNs == 0 || durationNs <= budgetNs) {
+        return;
+    }
+    U64 overBudget = account.overBudget.fetch_add(1, std::memory_order_relaxed) + 1;
+    U32 isolateAfter = m_isolateAfter.load(std::memory_order_relaxed);
+    if (isolateAfter > 0 && overBudget >= isolateAfter) {
+        account.isolated.store(true, std::memory_order_relaxed);
+    }
+    // 报告交给报告线程，不阻塞处理线程
+    if (table.budgetCallback && table.budgetReporter) {
+        BudgetCallback callback = table.budgetCallback;
+        table.budgetReporter->post([callback, frameType, durationNs]() {
+            callback(frameType, durationNs);
+        });
+    }
+}
+
+// 设置处理函数单次执行预算
+void AsyncFrameDispatcher::setHandlerBudget(U64 budgetNs, U32 isolateAfter) {
+    m_handlerBudgetNs.store(budgetNs, std::memory_order_relaxed);
+    m_isolateAfter.store(isolateAfter, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> guard(m_handlerMutex);
+    const FrameHandlerTable* current = m_handlerTable.load(std::memory_order_relaxed);
+    if (isolateAfter > 0 && !current->isolatedExecutor) {
+        publishTable([](FrameHandlerTable& table) {
+            table.isolatedExecutor = std::make_shared<SerialExecutor>();
+        });
+    }
+}
+
+// 设置超预算回调
+void AsyncFrameDispatcher::setBudgetExceededCallback(BudgetCallback callback) {
+    std::lock_guard<std::mutex> guard(m_handlerMutex);
+    publishTable([&](FrameHandlerTable& table) {
+        if (callback && !table.budgetReporter) {
+            table.budgetReporter = std::make_shared<SerialExecutor>();
         }
+        table.budgetCallback = std::move(callback);
+    });
+}
+
+// 获取某类帧主处理函数的执行统计
+HandlerStats AsyncFrameDispatcher::getHandlerStats(U8 frameType) const {
+    const HandlerAccount& account = m_handlerAccounts[frameType];
+    HandlerStats stats;
+    stats.invocations = account.invocations.load(std::memory_order_relaxed);
+    stats.totalNs = account.totalNs.load(std::memory_order_relaxed);
+    stats.maxNs = account.maxNs.load(std::memory_order_relaxed);
+    stats.cpuCycles = account.cpuCycles.load(std::memory_order_relaxed);
+    stats.overBudget = account.overBudget.load(std::memory_order_relaxed);
+    stats.isolated = account.isolated.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// 清零处理函数执行统计
+void AsyncFrameDispatcher::resetHandlerStats() {
+    for (auto& account : m_handlerAccounts) {
+        account.invocations.store(0, std::memory_order_relaxed);
+        account.totalNs.store(0, std::memory_order_relaxed);
+        account.maxNs.store(0, std::memory_order_relaxed);
+        account.cpuCycles.store(0, std::memory_order_relaxed);
+        account.overBudget.store(0, std::memory_order_relaxed);
+        account.isolated.store(false, std::memory_order_relaxed);
     }
 }
 
 // 分发帧
-void AsyncFrameDispatcher::dispatchFrame(const std::vector<U8>& frame, U32 len) {
+void AsyncFrameDispatcher::dispatchFrame(const std::vector<U8>& frame, U32 len, const FrameTiming& timing) {
     if (frame.empty() || len == 0) {
         return;
     }
     
     U8 frameType = frame[0];
+    U64 handlerStart = monotonicNowNs();
     
-    // 获取对应的处理函数
-    std::function<S32(const std::vector<U8>&, U32)> handler = nullptr;
-    {
-        std::lock_guard<std::mutex> guard(m_handlerMutex);
-        if (frameType < MAX_FRAME_TYPE) {
-            handler = m_frameHandlers[frameType];
+    // 获取对应的处理函数：进入读端区间取得快照后直接按下标调用，不加锁也不复制
+    TableReader reader(*this);
+    const FrameHandlerTable* table = reader.table;
+    
+    // 分发前中间件链（记录、追踪等），任一中间件返回 false 则拦截；
+    // 中间件抛出异常时视为放行，异常不能离开处理任务，否则不会再调度处理
+    for (const auto& entry : table->middlewares) {
+        bool pass = true;
+        try {
+            pass = entry.middleware(frame, len);
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in frame middleware " << entry.id << " for type 0x" 
+                      << std::hex << static_cast<int>(frameType) 
+                      << std::dec << ": " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Unknown exception in frame middleware " << entry.id << " for type 0x" 
+                      << std::hex << static_cast<int>(frameType) << std::dec << std::endl;
+        }
+        if (!pass) {
+            return;
         }
     }
     
+    const FrameHandler& handler = table->handlers[frameType];
+    const auto& subscribers = table->subscribers[frameType];
+
+    // 处理函数可通过 currentTiming() 读取本帧时间戳（INLINE 分发可能嵌套，退出时恢复）
+    const FrameTiming* outerTiming = t_currentTiming;
+    t_currentTiming = &timing;
+    
+    std::shared_ptr<const std::vector<U8>> isolatedFrame; // 主处理函数移到隔离执行器时的帧副本
     if (handler) {
+        if (table->isolatedExecutor && m_handlerAccounts[frameType].isolated.load(std::memory_order_relaxed)) {
+            // 超预算的处理函数改在隔离执行器中调用，不再占用处理线程
+            isolatedFrame = std::make_shared<const std::vector<U8>>(frame.begin(), frame.begin() + len);
+            FrameHandler isolatedHandler = handler;
+            table->isolatedExecutor->post([this, frameType, isolatedHandler, isolatedFrame, len, timing]() {
+                // 执行时重新读取当前快照，旧快照可能已被回收
+                TableReader reader(*this);
+                CurrentTimingScope scope(timing);
+                invokeHandler(*reader.table, frameType, isolatedHandler, *isolatedFrame, len);
+            });
+        } else {
+            invokeHandler(*table, frameType, handler, frame, len);
+        }
+    }
+    
+    // 订阅者共享同一帧：同步订阅者直接使用当前缓冲区，
+    // 异步订阅者共享一份只读副本（每帧最多复制一次）
+    std::shared_ptr<const std::vector<U8>> sharedFrame;
+    for (const auto& subscriber : subscribers) {
+        if (subscriber->filter && !subscriber->filter(frame, len)) {
+            continue;
+        }
+        if (subscriber->executor) {
+            if (!sharedFrame) {
+                sharedFrame = std::make_shared<const std::vector<U8>>(frame.begin(), frame.begin() + len);
+            }
+            std::shared_ptr<const FrameSubscriber> target = subscriber;
+            subscriber->executor->post([target, sharedFrame, len, timing]() {
+                CurrentTimingScope scope(timing);
+                target->handler(*sharedFrame, len);
+            });
+            continue;
+        }
         try {
-            handler(frame, len);
+            subscriber->handler(frame, len);
         } catch (const std::exception& e) {
-            std::cerr << "Exception in frame handler for type 0x" 
+            std::cerr << "Exception in frame subscriber " << subscriber->id << " for type 0x" 
                       << std::hex << static_cast<int>(frameType) 
                       << std::dec << ": " << e.what() << std::endl;
         }
-    } else {
+    }
+    
+    // 一次性等待者在主处理函数之后唤醒，恢复的协程能看到处理函数更新后的状态；
+    // 主处理函数已移到隔离执行器时，等待者排在同一执行器中该处理函数之后唤醒
+    std::vector<FrameWaitCallback> matched;
+    bool waited = m_waiterCount.load(std::memory_order_acquire) != 0 && takeWaiters(frame, len, matched);
+    if (waited && isolatedFrame) {
+        auto callbacks = std::make_shared<std::vector<FrameWaitCallback>>(std::move(matched));
+        table->isolatedExecutor->post([callbacks, isolatedFrame, len]() {
+            callWaiters(*callbacks, *isolatedFrame, len);
+        });
+    } else if (waited) {
+        callWaiters(matched, frame, len);
+    }
+    if (!handler && subscribers.empty() && !waited) {
         std::cerr << "Unknown frame type: 0x" 
                   << std::hex << static_cast<int>(frameType) << std::dec << std::endl;
     }
-}
+    
+    t_currentTiming = outerTiming;
+    
+    // 记录各阶段延迟（处理阶段包含主处理函数和同步订阅者）
+    m_latencyStats.record(frameType, timing, handlerStart, monotonicNowNs());
+}
\ No newline at end of file
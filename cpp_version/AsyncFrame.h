@@ -10,6 +10,9 @@
 #include <atomic>
 #include <string>
 #include <memory>
+#include <array>
+#include "Executor.h"
+#include "LatencyHistogram.h"
 
 
 // 使用 C++ using 别名替代 typedef
@@ -20,33 +23,240 @@ using S32 = int32_t;
 
 // 常量定义使用 constexpr
 constexpr U32 FRAME_QUEUE_SIZE = 1024;   // 队列大小
-constexpr U8 MAX_FRAME_TYPE = 127;      // 帧类型最大 256 种
+constexpr U32 FRAME_QUEUE_HIGH_WATER = FRAME_QUEUE_SIZE * 3 / 4; // 队列深度达到高水位时进入过载状态，收回接收许可
+constexpr U32 FRAME_QUEUE_LOW_WATER = FRAME_QUEUE_SIZE / 4;      // 队列深度降到低水位时退出过载状态，恢复接收许可
+constexpr U32 FRAME_DRAIN_BATCH = 64;    // 线程池模式下每次调度最多处理的帧数，避免单个设备长期占用工作线程
+constexpr U32 MAX_FRAME_TYPE = 256;     // 帧类型最大 256 种，覆盖 U8 全范围
 constexpr U8 MAX_CMD_LEN = 0x65;        // 最大业务命令长度，需与 CmdFrm.h 保持一致
 
-// 异步帧调度器类（单例模式）
+// 帧处理函数类型
+using FrameHandler = std::function<S32(const std::vector<U8>&, U32)>;
+
+// 订阅过滤器类型，返回 true 表示该订阅者接收此帧
+using FrameFilter = std::function<bool(const std::vector<U8>&, U32)>;
+
+// 分发前中间件类型，返回 false 表示拦截此帧，不再分发
+using FrameMiddleware = std::function<bool(const std::vector<U8>&, U32)>;
+
+// 帧时钟函数类型：返回帧的主机对齐时间（ns），0 表示未知；在放入帧的线程中调用，需短小且不阻塞
+using FrameClock = std::function<U64(const std::vector<U8>&, U32, const FrameTiming&)>;
+
+// 过载事件回调类型，overloaded 为 true 表示进入过载，false 表示恢复
+using OverloadCallback = std::function<void(bool overloaded)>;
+
+// 调度器运行统计
+struct DispatcherStats {
+    U32 queueDepth;      // 当前队列深度
+    U32 maxQueueDepth;   // 历史最大队列深度
+    U32 droppedFrames;   // 队列满时丢弃的帧数
+    U32 overloadEvents;  // 进入过载状态的次数
+    bool overloaded;     // 当前是否过载
+};
+
+// 处理函数超预算回调类型，durationNs 为本次执行耗时
+using BudgetCallback = std::function<void(U8 frameType, U64 durationNs)>;
+
+// 处理函数执行统计（按帧类型，只统计主处理函数）
+struct HandlerStats {
+    U64 invocations;     // 调用次数
+    U64 totalNs;         // 累计执行时间（ns）
+    U64 maxNs;           // 最长单次执行时间（ns）
+    U64 cpuCycles;       // 累计线程 CPU 周期数（Windows 下由 QueryThreadCycleTime 统计）
+    U64 overBudget;      // 超预算次数
+    bool isolated;       // 是否已移到隔离执行器
+};
+
+// 处理函数执行计数器
+struct HandlerAccount {
+    std::atomic<U64> invocations{0};
+    std::atomic<U64> totalNs{0};
+    std::atomic<U64> maxNs{0};
+    std::atomic<U64> cpuCycles{0};
+    std::atomic<U64> overBudget{0};
+    std::atomic<bool> isolated{false};
+};
+
+// 一次性等待回调类型，匹配的帧到达时在处理线程中调用一次；超时、取消或反初始化时以空帧（长度 0）调用
+using FrameWaitCallback = std::function<void(const std::vector<U8>&, U32)>;
+
+// 等待超时定时器类型：由所有者在 deadlineNs（单调时钟 ns）调用 expireWaiters，同一定时器重复登记时改为新的时间
+using WaiterTimer = std::function<void(U64)>;
+
+// 协程恢复调度器类型：把恢复任务投递到指定执行器，为空表示在处理线程中直接恢复
+using ResumeScheduler = std::function<void(ExecutorTask)>;
+
+// 一次性帧等待者
+struct FrameWaiter {
+    U32 id;                     // 等待句柄
+    U8 frameType;               // 帧类型
+    FrameFilter match;          // 可选匹配条件
+    FrameWaitCallback callback; // 匹配时调用的回调
+    U64 deadlineNs;             // 超时时间（单调时钟 ns），0 表示不超时
+};
+
+// 帧订阅者
+struct FrameSubscriber {
+    U32 id;                                   // 订阅句柄
+    FrameHandler handler;                     // 处理函数
+    FrameFilter filter;                       // 可选过滤器
+    std::shared_ptr<SerialExecutor> executor; // 异步订阅者的独立执行器，为空表示在处理线程中调用
+};
+
+// 分发前中间件
+struct FrameMiddlewareEntry {
+    U32 id;                     // 中间件句柄
+    FrameMiddleware middleware; // 中间件函数
+};
+
+// 回调函数表快照：发布后只读，修改时整表复制后原子替换（RCU 方式）
+struct FrameHandlerTable {
+    std::array<FrameHandler, MAX_FRAME_TYPE> handlers;                                     // 主处理函数
+    std::array<std::vector<std::shared_ptr<const FrameSubscriber>>, MAX_FRAME_TYPE> subscribers; // 订阅者
+    std::vector<FrameMiddlewareEntry> middlewares;                                         // 分发前中间件链
+    OverloadCallback overloadCallback;                                                     // 过载事件回调
+    FrameClock frameClock;                                                                 // 帧时钟函数
+    BudgetCallback budgetCallback;                                                         // 超预算回调
+    std::shared_ptr<SerialExecutor> budgetReporter;                                        // 超预算报告执行器，避免回调阻塞处理线程
+    std::shared_ptr<SerialExecutor> isolatedExecutor;                                      // 超预算处理函数的隔离执行器
+};
+
+// 帧分发模式
+enum class DispatchMode : U8 {
+    QUEUED,      // 按到达顺序排队，逐帧处理
+    CONFLATED,   // 只保留最新值：未处理的同类帧被新帧覆盖
+    INLINE       // 在放入帧的线程（I/O 线程）中直接分发，不经过队列，只用于短小且不阻塞的处理函数
+};
+
+// 队列槽位
+struct FrameSlot {
+    std::vector<U8> data;  // 帧数据（预分配 MAX_CMD_LEN）
+    U32 len;               // 有效长度，0 表示合并槽位标记
+    U8 conflateType;       // 合并槽位标记对应的帧类型
+    FrameTiming timing;    // 各阶段时间戳
+};
+
+// 合并槽位：每种帧类型最多保留一帧待处理数据
+struct ConflateSlot {
+    std::vector<U8> data;  // 最新一帧数据
+    U32 len;               // 有效长度
+    bool pending;          // 是否已在队列中等待处理
+    FrameTiming timing;    // 最新一帧的各阶段时间戳
+};
+
+// 编译器支持 C++20 协程时提供协程接口
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define FRAME_AWAITER_AVAILABLE 1
+class FrameAwaitable; // 协程等待对象，定义见 FrameAwaiter.h
+#endif
+
+// 异步帧调度器类
+// 每个设备一个实例；不指定线程池时使用独立处理线程，
+// 指定共享线程池时按设备串行地在线程池中处理，多设备可分摊到多个核
+// getInstance() 保留为单设备场景的默认实例
 class AsyncFrameDispatcher {
 private:
-    std::vector<std::vector<U8>> m_frameQueue;
+    std::vector<FrameSlot> m_frameQueue;
     U32 m_queueHead;           // 读指针
     U32 m_queueTail;           // 写指针
     std::mutex m_queueMutex;   // 队列互斥锁
     std::condition_variable m_frameCondition; // 帧到达条件变量
     std::thread m_processThread; // 处理线程
-    std::vector<std::function<S32(const std::vector<U8>&, U32)>> m_frameHandlers; // 回调函数表
+    std::atomic<const FrameHandlerTable*> m_handlerTable; // 当前发布的回调函数表快照
+    std::vector<std::unique_ptr<FrameHandlerTable>> m_handlerTables; // 已发布的快照（读端可能仍在使用，静止后回收）
+    std::atomic<U32> m_tableReaders;     // 正在使用快照的读端数，为 0 时旧快照可以回收
+    std::atomic<bool> m_tablesRetired;   // 有等待回收的旧快照
+    std::array<DispatchMode, MAX_FRAME_TYPE> m_dispatchModes; // 各帧类型分发模式（受 m_queueMutex 保护）
+    std::array<S32, MAX_FRAME_TYPE> m_conflateSubTypes; // 参与合并的子类型（frame[1]），-1 表示全部
+    std::vector<ConflateSlot> m_conflateSlots; // 合并槽位（受 m_queueMutex 保护）
+    std::array<std::atomic<U32>, MAX_FRAME_TYPE> m_conflatedCounts; // 各帧类型被覆盖的帧数
+    std::atomic<bool> m_overloaded;      // 过载状态（接收许可），传输层与解析器据此暂停读取
+    std::atomic<U32> m_maxQueueDepth;    // 历史最大队列深度
+    std::atomic<U32> m_droppedFrames;    // 丢弃帧数
+    std::atomic<U32> m_overloadEvents;   // 进入过载状态的次数
+    FrameLatencyStats m_latencyStats;    // 各帧类型各阶段延迟直方图
+    std::array<HandlerAccount, MAX_FRAME_TYPE> m_handlerAccounts; // 各帧类型处理函数执行统计
+    std::atomic<U64> m_handlerBudgetNs;  // 处理函数单次执行预算（ns），0 表示不检查
+    std::atomic<U32> m_isolateAfter;     // 超预算多少次后移到隔离执行器，0 表示不隔离
     std::atomic<bool> m_running; // 运行状态标志
-    std::mutex m_handlerMutex; // 回调函数表互斥锁
-
-    // 私有构造函数（单例模式）
-    AsyncFrameDispatcher();
+    std::mutex m_handlerMutex; // 回调函数表写端互斥锁（读端无锁）
+    U32 m_nextHandleId;        // 下一个订阅/中间件句柄（受 m_handlerMutex 保护）
+    std::shared_ptr<WorkerPool> m_workerPool; // 共享线程池，为空表示使用独立处理线程
+    bool m_drainScheduled;     // 是否已向线程池提交处理任务（受 m_queueMutex 保护）
+    std::vector<U8> m_drainBuffer; // 线程池模式下的处理缓冲区（同一时刻只有一个处理任务）
+    std::mutex m_waiterMutex;            // 一次性等待者互斥锁
+    std::vector<FrameWaiter> m_waiters;  // 一次性等待者（受 m_waiterMutex 保护）
+    std::atomic<U32> m_waiterCount;      // 等待者数量，为 0 时分发路径不加锁
+    U32 m_nextWaiterId;                  // 下一个等待句柄（受 m_waiterMutex 保护）
+    ResumeScheduler m_resumeScheduler;   // 协程默认恢复调度器（受 m_waiterMutex 保护）
+    WaiterTimer m_waiterTimer;           // 等待超时定时器（受 m_waiterMutex 保护）
+    U64 m_waiterTimerNs;                 // 已登记的超时定时器时间，0 表示未登记（受 m_waiterMutex 保护）
     
     // 处理线程函数
     void processThreadFunc();
+
+    // 处理队列中最多 maxFrames 帧，调用时需持有 lock
+    void drainFramesLocked(std::unique_lock<std::mutex>& lock, std::vector<U8>& frame, U32 maxFrames);
+
+    // 向线程池提交处理任务（需持有 m_queueMutex）
+    void scheduleDrainLocked();
+
+    // 线程池处理任务
+    void drainQueue();
+
+    // 队列深度（需持有 m_queueMutex）
+    U32 queueDepthLocked() const;
+
+    // 按队列深度更新过载状态（需持有 m_queueMutex），状态变化时返回 true
+    bool updateOverloadLocked();
+
+    // 通知过载状态变化（不持有 m_queueMutex 时调用）
+    void notifyOverload(bool overloaded);
     
+    // 记录入队时间并按帧时钟函数填写主机对齐时间
+    FrameTiming stampTiming(const std::vector<U8>& frame, U32 len, const FrameTiming& timing);
+
     // 分发帧
-    void dispatchFrame(const std::vector<U8>& frame, U32 len);
+    void dispatchFrame(const std::vector<U8>& frame, U32 len, const FrameTiming& timing);
+
+    // 取出与该帧匹配的一次性等待者的回调，有匹配时返回 true
+    bool takeWaiters(const std::vector<U8>& frame, U32 len, std::vector<FrameWaitCallback>& matched);
+
+    // 以该帧调用取出的等待者回调（不持有 m_waiterMutex 时调用）
+    static void callWaiters(std::vector<FrameWaitCallback>& matched, const std::vector<U8>& frame, U32 len);
+
+    // 以空帧调用已移出的等待者回调（不持有 m_waiterMutex 时调用）
+    static void failWaiters(std::vector<FrameWaitCallback>& callbacks);
+
+    // 按最早的超时时间登记定时器（需持有 m_waiterMutex），返回需登记的时间，0 表示无需登记
+    U64 armWaiterTimerLocked();
+
+    // 调用主处理函数并统计执行时间
+    void invokeHandler(const FrameHandlerTable& table, U8 frameType, const FrameHandler& handler,
+                       const std::vector<U8>& frame, U32 len);
+
+    // 复制当前快照并修改指定表项，然后发布新快照（需持有 m_handlerMutex）
+    void publishHandler(U8 frameType, FrameHandler handler);
+
+    // 复制当前快照，交给 modifier 修改后发布（需持有 m_handlerMutex）
+    void publishTable(const std::function<void(FrameHandlerTable&)>& modifier);
+
+    // 发布空表（需持有 m_handlerMutex）
+    void publishEmptyTable();
+
+    // 没有读端时回收除当前快照外的旧快照（需持有 m_handlerMutex），有读端时留给最后离开的读端
+    void reclaimHandlerTables();
+
+    // 读端区间：进入时计数并取得当前快照，离开时若为最后一个读端则回收旧快照
+    class TableReader;
 
 public:
-    // 获取单例实例
+    // 构造函数，workerPool 为空时 init() 会创建独立处理线程
+    explicit AsyncFrameDispatcher(std::shared_ptr<WorkerPool> workerPool = nullptr);
+
+    // 析构函数
+    ~AsyncFrameDispatcher();
+
+    // 获取默认实例（单设备场景）
     static AsyncFrameDispatcher& getInstance();
     
     // 禁止拷贝构造和赋值操作
@@ -64,13 +274,94 @@ public:
     void uninit();
     
     // 注册帧处理函数
-    void registerFrameHandler(U8 frameType, std::function<S32(const std::vector<U8>&, U32)> handler);
+    void registerFrameHandler(U8 frameType, FrameHandler handler);
     
     // 注销帧处理函数
     void unregisterFrameHandler(U8 frameType);
     
-    // 将一帧放入队列
-    S32 pushFrameToQueue(const std::vector<U8>& frame, U32 len);
+    // 订阅帧，同一帧类型可有多个订阅者，async 为 true 时在独立执行器中调用，返回订阅句柄
+    U32 subscribe(U8 frameType, FrameHandler handler, FrameFilter filter = nullptr, bool async = false);
+
+    // 取消订阅
+    void unsubscribe(U32 subscriptionId);
+
+    // 添加分发前中间件（按添加顺序执行），返回中间件句柄；中间件抛出异常时记录并放行该帧
+    U32 addMiddleware(FrameMiddleware middleware);
+
+    // 移除分发前中间件
+    void removeMiddleware(U32 middlewareId);
+
+    // 等待下一帧匹配的帧（一次性），回调在主处理函数和订阅者之后调用，返回等待句柄；
+    // timeoutMs 不为 0 时超时以空帧调用回调（需设置等待超时定时器）
+    U32 waitFrame(U8 frameType, FrameFilter match, FrameWaitCallback callback, U32 timeoutMs = 0);
+
+    // 取消等待并以空帧调用回调，等待者已被唤醒或不存在时返回 false
+    bool cancelWait(U32 waitId);
+
+    // 设置等待超时定时器，由所有者在登记的时间调用 expireWaiters
+    void setWaiterTimer(WaiterTimer timer);
+
+    // 以空帧唤醒 nowNs 之前超时的等待者，返回唤醒个数；仍有带超时的等待者时重新登记定时器
+    U32 expireWaiters(U64 nowNs);
+
+    // 设置协程默认恢复调度器
+    void setResumeScheduler(ResumeScheduler scheduler);
+
+    // 获取协程默认恢复调度器
+    ResumeScheduler getResumeScheduler();
+
+#ifdef FRAME_AWAITER_AVAILABLE
+    // 协程接口：co_await dispatcher.next(frameType) 得到下一帧该类型的帧，超时时为空，需包含 FrameAwaiter.h
+    FrameAwaitable next(U8 frameType, FrameFilter filter = nullptr, U32 timeoutMs = 0);
+#endif
+
+    // 将一帧放入队列，timing 为上游各阶段时间戳；INLINE 模式的帧直接在调用线程中分发
+    S32 pushFrameToQueue(const std::vector<U8>& frame, U32 len, const FrameTiming& timing = FrameTiming());
+
+    // 在调用线程中直接分发一帧（同步模式），使用与队列分发相同的回调函数表
+    S32 dispatchInline(const std::vector<U8>& frame, U32 len, const FrameTiming& timing = FrameTiming());
+
+    // 获取某类帧某阶段的延迟快照（p50/p99/p999/max）
+    LatencySnapshot getLatency(U8 frameType, LatencyStage stage) const { return m_latencyStats.snapshot(frameType, stage); }
+
+    // 清零延迟统计
+    void resetLatency() { m_latencyStats.reset(); }
+
+    // 设置处理函数单次执行预算，isolateAfter > 0 时超预算达到该次数的处理函数改在隔离执行器中调用
+    void setHandlerBudget(U64 budgetNs, U32 isolateAfter = 0);
+
+    // 设置超预算回调，在独立的报告线程中调用
+    void setBudgetExceededCallback(BudgetCallback callback);
+
+    // 获取某类帧主处理函数的执行统计
+    HandlerStats getHandlerStats(U8 frameType) const;
+
+    // 清零处理函数执行统计，并取消隔离
+    void resetHandlerStats();
+
+    // 是否有接收许可：过载时返回 false，传输层应暂停从系统缓冲区读取数据
+    bool hasCredit() const { return !m_overloaded.load(std::memory_order_acquire); }
+
+    // 设置过载事件回调
+    void setOverloadCallback(OverloadCallback callback);
+
+    // 设置帧时钟函数，每帧入队前调用一次填写 FrameTiming::alignedTime
+    void setFrameClock(FrameClock clock);
+
+    // 当前分发中的帧的各阶段时间戳，在主处理函数（含移到隔离执行器的）和订阅者中有效，其他情况返回全 0
+    static const FrameTiming& currentTiming();
+
+    // 获取运行统计
+    DispatcherStats getStats();
+
+    // 设置帧分发模式，subType >= 0 时只合并 frame[1] 等于 subType 的帧
+    void setDispatchMode(U8 frameType, DispatchMode mode, S32 subType = -1);
+
+    // 获取某类帧被合并（覆盖）的次数
+    U32 getConflatedCount(U8 frameType) const;
+
+    // 获取所有帧被合并（覆盖）的总次数
+    U32 getTotalConflatedCount() const;
 };
 
 
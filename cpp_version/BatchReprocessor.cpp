@@ -0,0 +1,125 @@
+#include <cmath>
+#include <deque>
+#include "BatchReprocessor.h"
+
+
+// 按参数组数和波形数分配
+void SweepResults::resize(U32 setCount, U32 waveCount) {
+    m_setCount = setCount;
+    m_waveCount = waveCount;
+    U64 size = static_cast<U64>(setCount) * waveCount;
+    m_status.assign(size, ECHO_RESULT_NO_ECHO);
+    m_thickness.assign(size, 0.0);
+    m_smoothed.assign(size, 0.0);
+    m_firstUs.assign(size, 0.0f);
+}
+
+// 找到回波的波形数
+U32 SweepResults::validCount(U32 set) const {
+    const S32* status = statusRow(set);
+    U32 count = 0;
+    for (U32 i = 0; i < m_waveCount; ++i) {
+        if (status[i] == ECHO_RESULT_OK) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// 与录制时设备厚度之差的绝对值均值
+double SweepResults::meanDeviation(U32 set, const std::vector<WaveBuffer>& waves) const {
+    const S32* status = statusRow(set);
+    const double* thickness = thicknessRow(set);
+    double total = 0.0;
+    U32 count = 0;
+    for (U32 i = 0; i < m_waveCount && i < waves.size(); ++i) {
+        if (status[i] == ECHO_RESULT_OK) {
+            total += std::fabs(thickness[i] - waves[i].header().thick);
+            ++count;
+        }
+    }
+    return count > 0 ? total / count : -1.0;
+}
+
+// 构造函数
+BatchReprocessor::BatchReprocessor(WorkStealingPool& pool, U32 grain)
+    : m_pool(pool),
+      m_grain(grain == 0 ? 1 : grain) {
+}
+
+// 计算一段组合：先拆出后半部分交给线程池（其他线程可窃取），再继续处理前半部分
+void BatchReprocessor::processRange(const std::vector<WaveBuffer>* waves, const std::vector<EchoSettings>* settings,
+                                    const std::vector<double>* gainDb, SweepResults* results, U64 begin, U64 end) {
+    while (end - begin > m_grain) {
+        U64 middle = begin + (end - begin) / 2;
+        m_pool.post([this, waves, settings, gainDb, results, middle, end]() {
+            processRange(waves, settings, gainDb, results, middle, end);
+        });
+        end = middle;
+    }
+
+    // 每个工作线程复用自己的分析器缓冲区
+    static thread_local EchoAnalyzer analyzer;
+    U32 waveCount = static_cast<U32>(waves->size());
+    for (U64 index = begin; index < end; ++index) {
+        U32 set = static_cast<U32>(index / waveCount);
+        U32 wave = static_cast<U32>(index % waveCount);
+        const WaveBuffer& buffer = (*waves)[wave];
+        EchoSettings setting = (*settings)[set];
+        setting.gainScale = static_cast<float>(std::pow(10.0, ((*gainDb)[set] - buffer.header().curGain) / 20.0));
+        EchoResult result;
+        analyzer.analyze(buffer, setting, result);
+        results->m_status[index] = result.status;
+        results->m_thickness[index] = result.thicknessMm;
+        results->m_firstUs[index] = static_cast<float>(result.firstUs);
+    }
+}
+
+// 重算全部组合
+void BatchReprocessor::run(const std::vector<WaveBuffer>& waves, const std::vector<DEVICE_ULTRA_PARAM_U>& paramSets,
+                           SweepResults& results) {
+    U32 setCount = static_cast<U32>(paramSets.size());
+    U32 waveCount = static_cast<U32>(waves.size());
+    results.resize(setCount, waveCount);
+    if (setCount == 0 || waveCount == 0) {
+        return;
+    }
+
+    std::vector<EchoSettings> settings(setCount);
+    std::vector<double> gainDb(setCount);
+    for (U32 set = 0; set < setCount; ++set) {
+        settings[set] = EchoAnalyzer::settingsFromParams(paramSets[set]);
+        gainDb[set] = paramSets[set].stParam.Gain1.value * BATCH_GAIN_UNIT_DB;
+    }
+
+    // 第一阶段：逐个波形重算厚度
+    U64 total = static_cast<U64>(setCount) * waveCount;
+    m_pool.post([this, &waves, &settings, &gainDb, &results, total]() {
+        processRange(&waves, &settings, &gainDb, &results, 0, total);
+    });
+    m_pool.wait();
+
+    // 第二阶段：按各组的平滑次数对连续波形的厚度做滑动平均（找不到回波时保持上一个显示值）
+    for (U32 set = 0; set < setCount; ++set) {
+        U32 window = paramSets[set].stParam.smoothTime.value > 0 ? paramSets[set].stParam.smoothTime.value : 1;
+        m_pool.post([&results, set, window, waveCount]() {
+            U64 row = static_cast<U64>(set) * waveCount;
+            std::deque<double> recent;
+            double acc = 0.0;
+            double shown = 0.0;
+            for (U32 i = 0; i < waveCount; ++i) {
+                if (results.m_status[row + i] == ECHO_RESULT_OK) {
+                    recent.push_back(results.m_thickness[row + i]);
+                    acc += recent.back();
+                    if (recent.size() > window) {
+                        acc -= recent.front();
+                        recent.pop_front();
+                    }
+                    shown = acc / recent.size();
+                }
+                results.m_smoothed[row + i] = shown;
+            }
+        });
+    }
+    m_pool.wait();
+}
@@ -0,0 +1,75 @@
+#ifndef __BATCH_REPROCESSOR_H__
+#define __BATCH_REPROCESSOR_H__
+
+#include <cstdint>
+#include <vector>
+#include "paramDefine.h"
+#include "Executor.h"
+#include "WaveBuffer.h"
+#include "EchoAnalyzer.h"
+
+
+// 使用 C++ using 别名替代 typedef
+using U32 = uint32_t;
+using U64 = uint64_t;
+using S32 = int32_t;
+
+constexpr U32 BATCH_GRAIN = 64;               // 递归拆分到不超过此数量的（参数组, 波形）组合后直接计算
+constexpr double BATCH_GAIN_UNIT_DB = 0.1;    // 增益参数 Gain1：0.1dB
+
+// 参数扫描结果：按参数组连续存放（第 set 组第 wave 个波形位于 set * waveCount + wave），
+// 同一参数组的整行可直接与其他参数组逐项比较
+class SweepResults {
+private:
+    U32 m_setCount;                  // 参数组数
+    U32 m_waveCount;                 // 波形数
+    std::vector<S32> m_status;       // 分析状态（ECHO_RESULT_*）
+    std::vector<double> m_thickness; // 单个波形重算的厚度（mm）
+    std::vector<double> m_smoothed;  // 按 smoothTime 平滑后的厚度（mm），模拟设备显示值
+    std::vector<float> m_firstUs;    // 一次回波位置（us）
+
+    friend class BatchReprocessor;
+
+public:
+    SweepResults() : m_setCount(0), m_waveCount(0) {}
+
+    // 按参数组数和波形数分配
+    void resize(U32 setCount, U32 waveCount);
+
+    U32 setCount() const { return m_setCount; }
+    U32 waveCount() const { return m_waveCount; }
+
+    // 第 set 组参数的整行结果
+    const S32* statusRow(U32 set) const { return m_status.data() + static_cast<U64>(set) * m_waveCount; }
+    const double* thicknessRow(U32 set) const { return m_thickness.data() + static_cast<U64>(set) * m_waveCount; }
+    const double* smoothedRow(U32 set) const { return m_smoothed.data() + static_cast<U64>(set) * m_waveCount; }
+    const float* firstEchoRow(U32 set) const { return m_firstUs.data() + static_cast<U64>(set) * m_waveCount; }
+
+    // 第 set 组参数找到回波的波形数
+    U32 validCount(U32 set) const;
+
+    // 第 set 组参数重算厚度与录制时设备厚度之差的绝对值均值（只计找到回波的波形），没有有效结果时返回 -1
+    double meanDeviation(U32 set, const std::vector<WaveBuffer>& waves) const;
+};
+
+// 离线批量重算：对录制的波形按多组设备参数（增益、闸门、声速、平滑次数等）重新检测回波并计算厚度。
+// （参数组, 波形）组合在工作窃取线程池中递归拆分，空闲线程窃取未拆分的大块，在所有核上均衡负载
+class BatchReprocessor {
+private:
+    WorkStealingPool& m_pool; // 工作窃取线程池
+    U32 m_grain;              // 拆分粒度
+
+    // 计算 [begin, end) 范围内的组合，范围大于粒度时拆出后半部分交给线程池
+    void processRange(const std::vector<WaveBuffer>* waves, const std::vector<EchoSettings>* settings,
+                      const std::vector<double>* gainDb, SweepResults* results, U64 begin, U64 end);
+
+public:
+    explicit BatchReprocessor(WorkStealingPool& pool, U32 grain = BATCH_GRAIN);
+
+    // 重算全部组合，阻塞到完成；不能在该线程池的工作线程中调用
+    void run(const std::vector<WaveBuffer>& waves, const std::vector<DEVICE_ULTRA_PARAM_U>& paramSets,
+             SweepResults& results);
+};
+
+
+#endif /*__BATCH_REPROCESSOR_H__*/
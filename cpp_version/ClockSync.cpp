@@ -0,0 +1,149 @@
+#include <cmath>
+#include "ClockSync.h"
+
+
+// 构造函数
+ClockSync::ClockSync() {
+    reset();
+}
+
+// 清空
+void ClockSync::reset() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_recentCount = 0;
+    m_historyCount = 0;
+    m_lastSelectedNs = 0;
+    m_sampleCount = 0;
+    m_minRttNs = 0;
+    m_anchorRttNs = 0;
+    m_originNs = 0;
+    m_anchorHost = 0.0;
+    m_anchorTicks = 0.0;
+    m_nsPerTick = CLOCK_DEVICE_TICK_NS;
+    m_synced = false;
+}
+
+// 由主机时间预测设备时间戳
+double ClockSync::predictTicksLocked(U64 hostNs) const {
+    double host = static_cast<double>(static_cast<S64>(hostNs - m_originNs));
+    return m_anchorTicks + (host - m_anchorHost) / m_nsPerTick;
+}
+
+// 展开 16 位时间戳
+U64 ClockSync::unwrap(U16 deviceTs, double predicted) {
+    double range = static_cast<double>(CLOCK_DEVICE_TS_RANGE);
+    double cycles = std::floor((predicted - deviceTs) / range + 0.5);
+    if (cycles < 0.0) {
+        cycles = 0.0;
+    }
+    return static_cast<U64>(cycles) * CLOCK_DEVICE_TS_RANGE + deviceTs;
+}
+
+// 按滤波后的样本最小二乘拟合，只有一个样本时按标称频率
+void ClockSync::refitLocked() {
+    double meanHost = 0.0;
+    double meanTicks = 0.0;
+    for (U32 i = 0; i < m_historyCount; ++i) {
+        meanHost += static_cast<double>(static_cast<S64>(m_history[i].hostNs - m_originNs));
+        meanTicks += static_cast<double>(m_history[i].deviceTicks);
+    }
+    meanHost /= m_historyCount;
+    meanTicks /= m_historyCount;
+
+    double nsPerTick = CLOCK_DEVICE_TICK_NS;
+    if (m_historyCount >= 2) {
+        double sxy = 0.0;
+        double sxx = 0.0;
+        for (U32 i = 0; i < m_historyCount; ++i) {
+            double dx = static_cast<double>(m_history[i].deviceTicks) - meanTicks;
+            double dy = static_cast<double>(static_cast<S64>(m_history[i].hostNs - m_originNs)) - meanHost;
+            sxy += dx * dy;
+            sxx += dx * dx;
+        }
+        if (sxx > 0.0) {
+            nsPerTick = sxy / sxx;
+        }
+        double limit = CLOCK_DEVICE_TICK_NS * CLOCK_MAX_DRIFT_PPM * 1e-6;
+        if (nsPerTick > CLOCK_DEVICE_TICK_NS + limit) nsPerTick = CLOCK_DEVICE_TICK_NS + limit;
+        if (nsPerTick < CLOCK_DEVICE_TICK_NS - limit) nsPerTick = CLOCK_DEVICE_TICK_NS - limit;
+    }
+    m_anchorHost = meanHost;
+    m_anchorTicks = meanTicks;
+    m_nsPerTick = nsPerTick;
+    m_synced = true;
+}
+
+// 加入一次交换
+void ClockSync::addSample(U64 sendNs, U64 recvNs, U16 deviceTs) {
+    if (recvNs < sendNs) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(m_mutex);
+    ClockSample sample;
+    sample.rttNs = recvNs - sendNs;
+    sample.hostNs = sendNs + sample.rttNs / 2;
+    if (m_synced) {
+        sample.deviceTicks = unwrap(deviceTs, predictTicksLocked(sample.hostNs));
+    } else {
+        // 第一次交换作为原点，展开后的时间戳从第二个循环开始，避免早于原点的时间戳出现负值
+        m_originNs = sample.hostNs;
+        sample.deviceTicks = CLOCK_DEVICE_TS_RANGE + deviceTs;
+    }
+    ++m_sampleCount;
+    if (m_minRttNs == 0 || sample.rttNs < m_minRttNs) {
+        m_minRttNs = sample.rttNs;
+    }
+
+    // 最近的交换按到达顺序循环存放
+    m_recent[(m_sampleCount - 1) % CLOCK_FILTER_SIZE] = sample;
+    if (m_recentCount < CLOCK_FILTER_SIZE) {
+        ++m_recentCount;
+    }
+
+    // 取往返时间最短的一次，比上次选中的更新时才加入拟合样本
+    const ClockSample* best = &m_recent[0];
+    for (U32 i = 1; i < m_recentCount; ++i) {
+        if (m_recent[i].rttNs < best->rttNs) {
+            best = &m_recent[i];
+        }
+    }
+    if (m_historyCount > 0 && best->hostNs <= m_lastSelectedNs) {
+        return;
+    }
+    m_lastSelectedNs = best->hostNs;
+    m_anchorRttNs = best->rttNs;
+    if (m_historyCount == CLOCK_HISTORY_SIZE) {
+        for (U32 i = 1; i < CLOCK_HISTORY_SIZE; ++i) {
+            m_history[i - 1] = m_history[i];
+        }
+        --m_historyCount;
+    }
+    m_history[m_historyCount++] = *best;
+    refitLocked();
+}
+
+// 设备时间戳换算为主机时间
+bool ClockSync::toHostNs(U16 deviceTs, U64 nearHostNs, U64& hostNs) const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if (!m_synced) {
+        return false;
+    }
+    double ticks = static_cast<double>(unwrap(deviceTs, predictTicksLocked(nearHostNs)));
+    double host = m_anchorHost + (ticks - m_anchorTicks) * m_nsPerTick;
+    hostNs = m_originNs + static_cast<U64>(static_cast<S64>(std::llround(host)));
+    return true;
+}
+
+// 当前估计
+ClockEstimate ClockSync::estimate() const {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    ClockEstimate result;
+    result.synced = m_synced;
+    result.nsPerTick = m_nsPerTick;
+    result.driftPpm = (m_nsPerTick / CLOCK_DEVICE_TICK_NS - 1.0) * 1e6;
+    result.offsetNs = static_cast<S64>(m_originNs) + std::llround(m_anchorHost - m_anchorTicks * m_nsPerTick);
+    result.rttNs = m_anchorRttNs;
+    result.minRttNs = m_minRttNs;
+    result.samples = m_sampleCount;
+    return result;
+}
@@ -0,0 +1,88 @@
+#ifndef __CLOCK_SYNC_H__
+#define __CLOCK_SYNC_H__
+
+#include <cstdint>
+#include <array>
+#include <mutex>
+
+
+// 使用 C++ using 别名替代 typedef
+using U16 = uint16_t;
+using U32 = uint32_t;
+using U64 = uint64_t;
+using S64 = int64_t;
+
+constexpr double CLOCK_DEVICE_TICK_NS = 1000000.0; // 设备时间戳标称单位（1ms），实际频率由频偏估计修正
+constexpr U64 CLOCK_DEVICE_TS_RANGE = 1u << 16;    // 设备时间戳为 16 位，循环计数
+constexpr U32 CLOCK_FILTER_SIZE = 8;               // 最小往返时间滤波窗口：取最近 8 次交换中往返时间最短的一次
+constexpr U32 CLOCK_HISTORY_SIZE = 16;             // 参与频偏拟合的滤波后样本数
+constexpr double CLOCK_MAX_DRIFT_PPM = 1000.0;     // 频偏估计上限，超出时按上限处理
+
+// 一次时间交换
+struct ClockSample {
+    U64 hostNs;      // 主机时间（发送与接收的中点，单调时钟 ns）
+    U64 deviceTicks; // 展开后的设备时间戳（不再循环）
+    U64 rttNs;       // 往返时间
+};
+
+// 时钟估计
+struct ClockEstimate {
+    bool synced;       // 是否已有可用估计
+    S64 offsetNs;      // 展开后设备时间戳 0 对应的主机时间（ns）
+    double nsPerTick;  // 每个设备时间戳单位对应的主机时间（ns）
+    double driftPpm;   // 设备时钟相对标称频率的频偏（ppm），设备走得慢时为正
+    U64 rttNs;         // 当前锚点样本的往返时间
+    U64 minRttNs;      // 历史最短往返时间
+    U32 samples;       // 收到的交换次数
+};
+
+// 设备时钟同步：按 NTP 的方式，每次交换以主机发送、接收时间的中点对应设备时间戳，
+// 最近若干次交换中只取往返时间最短的一次（排队、重传造成的不对称延迟最小），
+// 滤波后的样本按最小二乘拟合设备时间戳到主机时间的直线，得到偏移和频偏。
+// 16 位设备时间戳按当前估计预测的值展开，交换间隔不必短于一个循环周期。线程安全
+class ClockSync {
+private:
+    mutable std::mutex m_mutex;
+    std::array<ClockSample, CLOCK_FILTER_SIZE> m_recent;   // 最近的交换
+    std::array<ClockSample, CLOCK_HISTORY_SIZE> m_history; // 滤波后的样本
+    U32 m_recentCount;
+    U32 m_historyCount;
+    U64 m_lastSelectedNs;  // 上一次选中样本的主机时间，滤波结果不变时不重复加入
+    U32 m_sampleCount;
+    U64 m_minRttNs;
+    U64 m_anchorRttNs;
+    // 拟合直线：主机时间 = m_originNs + m_anchorHost + (设备时间戳 - m_anchorTicks) × m_nsPerTick
+    U64 m_originNs;        // 主机时间原点（第一次交换），拟合在相对时间上进行以保持精度
+    double m_anchorHost;
+    double m_anchorTicks;
+    double m_nsPerTick;
+    bool m_synced;
+
+    // 由主机时间预测展开后的设备时间戳（需持有 m_mutex，已同步）
+    double predictTicksLocked(U64 hostNs) const;
+
+    // 取与 predicted 最接近、低 16 位等于 deviceTs 的展开值
+    static U64 unwrap(U16 deviceTs, double predicted);
+
+    // 由滤波后的样本重新拟合（需持有 m_mutex）
+    void refitLocked();
+
+public:
+    ClockSync();
+
+    // 清空（设备重新连接后时间戳可能重新开始）
+    void reset();
+
+    // 加入一次交换：sendNs 为请求发出时间，recvNs 为应答到达时间，deviceTs 为应答中的设备时间戳
+    void addSample(U64 sendNs, U64 recvNs, U16 deviceTs);
+
+    // 设备时间戳换算为主机时间：nearHostNs 为与该时间戳相近的主机时间（如帧到达时间），用于展开循环；
+    // 尚未同步时返回 false
+    bool toHostNs(U16 deviceTs, U64 nearHostNs, U64& hostNs) const;
+
+    // 当前估计
+    ClockEstimate estimate() const;
+};
+
+
+#endif /*__CLOCK_SYNC_H__*/
@@ -8,19 +8,22 @@
 U32 frameCount = 0;
 
 // 构造函数
-CommandFrame::CommandFrame(FrameBuffer& buffer)
+CommandFrame::CommandFrame(FrameBuffer& buffer, AsyncFrameDispatcher& dispatcher)
     : m_recvBuffer(buffer),
+      m_dispatcher(dispatcher),
       m_readBuffer(MAX_CMD_LEN),
       m_state(FrameBufState::FIND_HEAD),
       m_expectedLen(0),
-      m_frameShortCount(0) {
+      m_frameShortCount(0),
+      m_lastRxTime(0) {
 }
 
 // 将数据放入接收缓冲区
-S32 CommandFrame::putFrameData(const std::vector<U8>& buffer, S32 dataByte) {
+S32 CommandFrame::putFrameData(const std::vector<U8>& buffer, S32 dataByte, U64 rxTime) {
     if (buffer.empty() || dataByte <= 0) {
         return -1;
     }
+    m_lastRxTime = rxTime;
     return m_recvBuffer.put(buffer.data(), dataByte);
 }
 
@@ -100,6 +103,9 @@ U32 CommandFrame::hasCompleteFrame(std::vector<U8>& buffer) {
                         m_recvBuffer.drop(uFRAME_END_LEN);
 
                         frameCount++;
+                        // 帧以完成它的那次读取为准记录时间
+                        m_timing.rxTime = m_lastRxTime;
+                        m_timing.parsedTime = monotonicNowNs();
                         m_state = FrameBufState::FIND_HEAD;
                         available -= m_expectedLen;
                         // 返回完整帧长度
@@ -128,15 +134,14 @@ U32 CommandFrame::hasCompleteFrame(std::vector<U8>& buffer) {
 void CommandFrame::processFrame(bool asyncMode) {
     U16 len = 0;
     
-    if ((len = hasCompleteFrame(m_readBuffer)) > 0) {
+    // 提取缓冲区中的所有完整帧；异步模式下调度器没有接收许可时停止提取，剩余数据留在缓冲区中
+    while ((!asyncMode || m_dispatcher.hasCredit()) && (len = hasCompleteFrame(m_readBuffer)) > 0) {
         if (asyncMode) {
             // 异步模式，入队列
-            AsyncFrameDispatcher::getInstance().pushFrameToQueue(m_readBuffer, len);
+            m_dispatcher.pushFrameToQueue(m_readBuffer, len, m_timing);
         } else {
-            // 同步模式，直接处理命令
-            U8 frameType = m_readBuffer[0];
-            // 这里可以根据需要添加具体的命令处理逻辑
-            std::cerr << "Sync processing frame type: 0x" << std::hex << static_cast<int>(frameType) << std::dec << std::endl;
+            // 同步模式，在当前线程中直接调用回调函数表
+            m_dispatcher.dispatchInline(m_readBuffer, len, m_timing);
         }
     }
 }
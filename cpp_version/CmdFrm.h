@@ -2,6 +2,7 @@
 #define __COMMAND_FRAME_H__
 
 #include "FrmBuf.h"
+#include "AsyncFrame.h"
 #include <cstdint>
 #include <vector>
 
@@ -41,14 +42,17 @@ enum class FrameBufState {
 class CommandFrame {
 private:
     FrameBuffer& m_recvBuffer;        // 引用接收缓冲区
+    AsyncFrameDispatcher& m_dispatcher; // 引用所属设备的帧调度器
     std::vector<U8> m_readBuffer;     // 读取缓冲区
     FrameBufState m_state;            // 当前帧处理状态
     S32 m_expectedLen;                // 当前帧的期望长度
     U16 m_frameShortCount;            // 不完整帧计数
+    U64 m_lastRxTime;                 // 最近一次放入数据的系统读取时间
+    FrameTiming m_timing;             // 当前提取帧的时间戳
 
 public:
     // 构造函数
-    CommandFrame(FrameBuffer& buffer);
+    CommandFrame(FrameBuffer& buffer, AsyncFrameDispatcher& dispatcher = AsyncFrameDispatcher::getInstance());
     
     // 析构函数
     ~CommandFrame() = default;
@@ -61,8 +65,8 @@ public:
     CommandFrame(CommandFrame&&) noexcept = default;
     CommandFrame& operator=(CommandFrame&&) noexcept = default;
     
-    // 将数据放入接收缓冲区
-    S32 putFrameData(const std::vector<U8>& buffer, S32 dataByte);
+    // 将数据放入接收缓冲区，rxTime 为传输层读取完成时间（0 表示未知）
+    S32 putFrameData(const std::vector<U8>& buffer, S32 dataByte, U64 rxTime = 0);
     
     // 检查并提取完整帧
     U32 hasCompleteFrame(std::vector<U8>& buffer);
@@ -0,0 +1,118 @@
+#ifndef __COALESCING_PUBLISHER_H__
+#define __COALESCING_PUBLISHER_H__
+
+#include <cstdint>
+#include <mutex>
+
+
+// 使用 C++ using 别名替代 typedef
+using U32 = uint32_t;
+using U64 = uint64_t;
+
+constexpr U64 PUBLISH_DEFAULT_INTERVAL_NS = 50000000; // 默认最短发布间隔（50ms，界面刷新 20 次/秒）
+
+// offer 的结果
+constexpr U32 PUBLISH_NOW = 0;       // 距上次发布已超过间隔，立即发布 out
+constexpr U32 PUBLISH_SCHEDULE = 1;  // 需在 deadlineNs 调用 flush 发布
+constexpr U32 PUBLISH_COALESCED = 2; // 已合并到等待发布的数据中
+
+// 两次发布之间的数据汇总
+template <typename T>
+struct CoalescedUpdate {
+    T latest; // 最新值
+    T min;    // 最小值
+    T max;    // 最大值
+    U32 count; // 数据个数
+};
+
+// 合并发布：两次发布之间至少间隔 interval，期间到达的数据合并为最新值及最小/最大值、个数。
+// 间隔已过时数据立即发布；否则由调用者在 offer 返回的时间调用 flush 发布累积的数据，
+// 因此无论数据频率多高，发布频率不超过 1/interval，最后一个数据最多延迟 interval 发布。线程安全
+template <typename T>
+class CoalescingPublisher {
+private:
+    mutable std::mutex m_mutex;
+    U64 m_intervalNs;          // 最短发布间隔
+    U64 m_lastPublishNs;       // 上次发布时间，0 表示尚未发布
+    bool m_scheduled;          // 已请求调用者在间隔结束时 flush
+    CoalescedUpdate<T> m_pending; // 等待发布的汇总，count 为 0 表示没有
+    U64 m_offeredCount;        // 收到的数据数
+    U64 m_publishedCount;      // 发布次数
+
+    // 取出汇总并记录发布（需持有 m_mutex）
+    void takeLocked(U64 nowNs, CoalescedUpdate<T>& out) {
+        out = m_pending;
+        m_pending.count = 0;
+        m_lastPublishNs = nowNs;
+        ++m_publishedCount;
+    }
+
+public:
+    explicit CoalescingPublisher(U64 intervalNs = PUBLISH_DEFAULT_INTERVAL_NS)
+        : m_intervalNs(intervalNs),
+          m_lastPublishNs(0),
+          m_scheduled(false),
+          m_pending{T(), T(), T(), 0},
+          m_offeredCount(0),
+          m_publishedCount(0) {
+    }
+
+    // 设置最短发布间隔，0 表示每个数据都立即发布
+    void setInterval(U64 intervalNs) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_intervalNs = intervalNs;
+    }
+
+    U64 interval() const {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        return m_intervalNs;
+    }
+
+    // 加入一个数据：返回 PUBLISH_NOW 时发布 out；返回 PUBLISH_SCHEDULE 时在 deadlineNs 调用 flush
+    U32 offer(const T& value, U64 nowNs, CoalescedUpdate<T>& out, U64& deadlineNs) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        ++m_offeredCount;
+        if (m_pending.count == 0) {
+            m_pending = {value, value, value, 1};
+        } else {
+            m_pending.latest = value;
+            if (value < m_pending.min) m_pending.min = value;
+            if (m_pending.max < value) m_pending.max = value;
+            ++m_pending.count;
+        }
+        if (m_scheduled) {
+            return PUBLISH_COALESCED;
+        }
+        if (m_lastPublishNs == 0 || nowNs - m_lastPublishNs >= m_intervalNs) {
+            takeLocked(nowNs, out);
+            return PUBLISH_NOW;
+        }
+        m_scheduled = true;
+        deadlineNs = m_lastPublishNs + m_intervalNs;
+        return PUBLISH_SCHEDULE;
+    }
+
+    // 间隔结束：有累积的数据时取出并返回 true
+    bool flush(U64 nowNs, CoalescedUpdate<T>& out) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_scheduled = false;
+        if (m_pending.count == 0) {
+            return false;
+        }
+        takeLocked(nowNs, out);
+        return true;
+    }
+
+    // 收到的数据数和发布次数
+    U64 getOfferedCount() const {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        return m_offeredCount;
+    }
+    U64 getPublishedCount() const {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        return m_publishedCount;
+    }
+};
+
+
+#endif /*__COALESCING_PUBLISHER_H__*/
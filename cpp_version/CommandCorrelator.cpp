@@ -0,0 +1,178 @@
+#include <iostream>
+#include "CommandCorrelator.h"
+
+
+// 构造函数
+CommandCorrelator::CommandCorrelator()
+    : m_nextId(1) {
+}
+
+// 业务命令的关联键
+bool CommandCorrelator::keyOfCommand(const std::vector<U8>& cmd, CorrelationKey& key) {
+    if (cmd.size() < 3) {
+        return false;
+    }
+    switch (cmd[0]) {
+    case 0x11: // 参数读写/重置，按读写标志和参数序号（0xFF 表示全部）区分
+        key = {cmd[0], cmd[1], cmd[2]};
+        return true;
+    case 0x33: // 测厚开始/停止/标定
+        key = {cmd[0], cmd[1], 0};
+        return true;
+    case 0x22: // 请求波形，应答为信息帧；确认反馈不需要应答
+        if (cmd[1] != 0x55) {
+            return false;
+        }
+        key = {cmd[0], cmd[1], 0};
+        return true;
+    case 0x41: // 时间校准
+    case 0x42: // 版本信息
+    case 0x44: // 电量信息
+        key = {cmd[0], 0, 0};
+        return true;
+    default:
+        return false;
+    }
+}
+
+// 应答帧的关联键
+bool CommandCorrelator::keyOfResponse(const std::vector<U8>& frame, U32 len, CorrelationKey& key) {
+    if (len < 3 || frame.size() < 3) {
+        return false;
+    }
+    switch (frame[0]) {
+    case 0x11:
+        key = {frame[0], frame[1], frame[2]};
+        return true;
+    case 0x33:
+        key = {frame[0], frame[1], 0};
+        return true;
+    case 0x22: // 只有信息帧是请求波形的应答，数据帧和确认帧不是
+        if (frame[1] != 0x00) {
+            return false;
+        }
+        key = {frame[0], 0x55, 0};
+        return true;
+    case 0x41:
+    case 0x42:
+    case 0x44:
+        key = {frame[0], 0, 0};
+        return true;
+    default:
+        return false;
+    }
+}
+
+// 登记请求
+U32 CommandCorrelator::track(const std::vector<U8>& cmd, const std::vector<U8>& wireFrame, U64 sendTime,
+                             std::shared_ptr<std::promise<CommandResult>> promise, ResponseCallback callback) {
+    CorrelationKey key;
+    if (!keyOfCommand(cmd, key)) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(m_mutex);
+    U32 id = m_nextId++;
+    if (m_nextId == 0 || m_nextId >= REQUEST_ID_LIMIT) {
+        m_nextId = 1; // 0 保留为无效句柄
+    }
+    m_pending.push_back({id, key, wireFrame, sendTime, 0, std::move(promise), std::move(callback)});
+    return id;
+}
+
+// 处理一帧应答
+bool CommandCorrelator::onResponse(const std::vector<U8>& frame, U32 len) {
+    CorrelationKey key;
+    if (!keyOfResponse(frame, len, key)) {
+        return false;
+    }
+    PendingRequest request;
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        auto it = m_pending.begin();
+        while (it != m_pending.end() && !(it->key == key)) {
+            ++it;
+        }
+        if (it == m_pending.end()) {
+            return false; // 迟到或重复的应答
+        }
+        request = std::move(*it);
+        m_pending.erase(it);
+    }
+    complete(request, CMD_RESULT_OK, frame, len);
+    return true;
+}
+
+// 准备重发
+bool CommandCorrelator::retry(U32 requestId, U32 maxRetries, std::vector<U8>& wireFrame, U32& attempt) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    for (auto& request : m_pending) {
+        if (request.id == requestId) {
+            if (request.attempts >= maxRetries) {
+                return false;
+            }
+            attempt = ++request.attempts;
+            wireFrame = request.wireFrame;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 以指定状态结束请求
+bool CommandCorrelator::fail(U32 requestId, S32 status) {
+    PendingRequest request;
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        auto it = m_pending.begin();
+        while (it != m_pending.end() && it->id != requestId) {
+            ++it;
+        }
+        if (it == m_pending.end()) {
+            return false;
+        }
+        request = std::move(*it);
+        m_pending.erase(it);
+    }
+    complete(request, status, std::vector<U8>(), 0);
+    return true;
+}
+
+// 取消所有在途请求
+void CommandCorrelator::cancelAll() {
+    std::deque<PendingRequest> pending;
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        pending.swap(m_pending);
+    }
+    for (auto& request : pending) {
+        complete(request, CMD_RESULT_CANCELLED, std::vector<U8>(), 0);
+    }
+}
+
+// 在途请求数
+U32 CommandCorrelator::pendingCount() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return static_cast<U32>(m_pending.size());
+}
+
+// 完成请求：先通知请求结束，再完成 future，最后调用回调
+void CommandCorrelator::complete(PendingRequest& request, S32 status, const std::vector<U8>& frame, U32 len) {
+    if (m_completionHook) {
+        m_completionHook(request.id);
+    }
+    if (request.promise) {
+        CommandResult result;
+        result.status = status;
+        result.frame.assign(frame.begin(), frame.begin() + len);
+        request.promise->set_value(std::move(result));
+    }
+    if (request.callback) {
+        try {
+            request.callback(status, frame, len);
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in response callback for command 0x"
+                      << std::hex << static_cast<int>(request.key.cmd)
+                      << std::dec << ": " << e.what() << std::endl;
+        }
+    }
+}
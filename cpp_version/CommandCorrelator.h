@@ -0,0 +1,110 @@
+#ifndef __COMMAND_CORRELATOR_H__
+#define __COMMAND_CORRELATOR_H__
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <future>
+#include <functional>
+#include <memory>
+
+
+// 使用 C++ using 别名替代 typedef
+using U8 = uint8_t;
+using U32 = uint32_t;
+using S32 = int32_t;
+using U64 = uint64_t;
+
+// 请求结果状态
+constexpr S32 CMD_RESULT_OK = 0;          // 收到应答
+constexpr S32 CMD_RESULT_TIMEOUT = -1;    // 超时未收到应答
+constexpr S32 CMD_RESULT_CANCELLED = -2;  // 请求被取消（断开连接等）
+constexpr S32 CMD_RESULT_REJECTED = -3;   // 收到应答，但设备返回失败（如参数写入结果 0xCC）
+
+// 请求与应答的关联键：命令字、子命令（读写标志）、参数序号
+struct CorrelationKey {
+    U8 cmd;
+    U8 subCmd;
+    U8 paramId;
+
+    bool operator==(const CorrelationKey& other) const {
+        return cmd == other.cmd && subCmd == other.subCmd && paramId == other.paramId;
+    }
+};
+
+// 请求结果
+struct CommandResult {
+    S32 status;             // 结果状态
+    std::vector<U8> frame;  // 应答帧（业务命令部分），失败时为空
+};
+
+// 应答回调类型，在处理应答的线程中调用；失败时 frame 为空、len 为 0
+using ResponseCallback = std::function<void(S32 status, const std::vector<U8>& frame, U32 len)>;
+
+// 请求结束（应答、超时或取消）通知类型
+constexpr U32 REQUEST_ID_LIMIT = 0xFFFFFF00u; // 请求句柄上限，以上的值保留给与请求共用重发时间轮的其他定时器
+
+using CompletionHook = std::function<void(U32 requestId)>;
+
+// 请求/应答关联表：线程安全，允许多个请求同时在途，
+// 应答按关联键匹配最早发出的同键请求，并完成对应的 future 和回调
+class CommandCorrelator {
+private:
+    // 在途请求
+    struct PendingRequest {
+        U32 id;                                               // 请求句柄
+        CorrelationKey key;                                   // 关联键
+        std::vector<U8> wireFrame;                            // 已编码的传输帧（用于重发）
+        U64 sendTime;                                         // 首次发送时间（单调时钟 ns）
+        U32 attempts;                                         // 已重发次数
+        std::shared_ptr<std::promise<CommandResult>> promise; // 请求结果
+        ResponseCallback callback;                            // 可选回调
+    };
+
+    std::mutex m_mutex;                   // 关联表互斥锁
+    std::deque<PendingRequest> m_pending; // 在途请求，按发出顺序排列
+    U32 m_nextId;                         // 下一个请求句柄
+    CompletionHook m_completionHook;      // 请求结束通知
+
+    // 完成请求（不持有 m_mutex 时调用）
+    void complete(PendingRequest& request, S32 status, const std::vector<U8>& frame, U32 len);
+
+public:
+    CommandCorrelator();
+
+    // 禁止拷贝构造和赋值操作
+    CommandCorrelator(const CommandCorrelator&) = delete;
+    CommandCorrelator& operator=(const CommandCorrelator&) = delete;
+
+    // 业务命令的关联键，命令不需要应答时返回 false
+    static bool keyOfCommand(const std::vector<U8>& cmd, CorrelationKey& key);
+
+    // 应答帧的关联键，不是应答帧（如主动上报的厚度数据）时返回 false
+    static bool keyOfResponse(const std::vector<U8>& frame, U32 len, CorrelationKey& key);
+
+    // 登记请求，需在发送之前调用，避免应答早于登记到达；返回请求句柄，0 表示命令不需要应答
+    U32 track(const std::vector<U8>& cmd, const std::vector<U8>& wireFrame, U64 sendTime,
+              std::shared_ptr<std::promise<CommandResult>> promise, ResponseCallback callback);
+
+    // 处理一帧应答，匹配到在途请求时完成该请求并返回 true
+    bool onResponse(const std::vector<U8>& frame, U32 len);
+
+    // 准备重发：请求仍在途且重发次数未达上限时取出传输帧并计数，返回 true
+    bool retry(U32 requestId, U32 maxRetries, std::vector<U8>& wireFrame, U32& attempt);
+
+    // 设置请求结束通知，需在发出请求之前设置
+    void setCompletionHook(CompletionHook hook) { m_completionHook = std::move(hook); }
+
+    // 以指定状态结束请求，请求已完成或不存在时返回 false
+    bool fail(U32 requestId, S32 status);
+
+    // 取消所有在途请求
+    void cancelAll();
+
+    // 在途请求数
+    U32 pendingCount();
+};
+
+
+#endif /*__COMMAND_CORRELATOR_H__*/
@@ -0,0 +1,228 @@
+#include <cmath>
+#include "EchoAnalyzer.h"
+#include "SimdConfig.h"
+#if defined(SIMD_AVX2) || defined(SIMD_SSE2)
+#include <emmintrin.h>
+#define ECHO_SSE2
+#endif
+
+
+// 去直流并全波整流：dst[i] = |src[i] - mean|
+static void rectify(float* data, U32 n, float mean) {
+    U32 i = 0;
+#ifdef ECHO_SSE2
+    const __m128 offset = _mm_set1_ps(mean);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_sub_ps(_mm_loadu_ps(data + i), offset);
+        _mm_storeu_ps(data + i, _mm_andnot_ps(signMask, v));
+    }
+#endif
+    for (; i < n; ++i) {
+        data[i] = std::fabs(data[i] - mean);
+    }
+}
+
+// 求和
+static float sum(const float* data, U32 n) {
+    U32 i = 0;
+    float total = 0.0f;
+#ifdef ECHO_SSE2
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_add_ps(acc, _mm_loadu_ps(data + i));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < n; ++i) {
+        total += data[i];
+    }
+    return total;
+}
+
+// 最大值
+static float maxOf(const float* data, U32 n) {
+    U32 i = 0;
+    float result = 0.0f;
+#ifdef ECHO_SSE2
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_max_ps(acc, _mm_loadu_ps(data + i));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    for (float lane : lanes) {
+        if (lane > result) result = lane;
+    }
+#endif
+    for (; i < n; ++i) {
+        if (data[i] > result) result = data[i];
+    }
+    return result;
+}
+
+// 居中滑动平均，边界处按实际覆盖的点数平均
+static void boxcar(const float* src, float* dst, U32 n, U32 width) {
+    U32 half = width / 2;
+    double acc = 0.0;
+    U32 lo = 0;
+    U32 hi = 0; // 窗口 [lo, hi)
+    for (U32 i = 0; i < n; ++i) {
+        U32 wantHi = i + half + 1 < n ? i + half + 1 : n;
+        U32 wantLo = i > half ? i - half : 0;
+        while (hi < wantHi) acc += src[hi++];
+        while (lo < wantLo) acc -= src[lo++];
+        dst[i] = static_cast<float>(acc / (hi - lo));
+    }
+}
+
+// 缩放并限幅
+void scaleSamples(const S16* samples, U32 n, float gainScale, float* dst) {
+    convertSamples(samples, dst, n);
+    if (gainScale == 1.0f) {
+        return;
+    }
+    U32 i = 0;
+#ifdef ECHO_SSE2
+    const __m128 scale = _mm_set1_ps(gainScale);
+    const __m128 upper = _mm_set1_ps(32767.0f);
+    const __m128 lower = _mm_set1_ps(-32768.0f);
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(dst + i), scale);
+        _mm_storeu_ps(dst + i, _mm_max_ps(_mm_min_ps(v, upper), lower));
+    }
+#endif
+    for (; i < n; ++i) {
+        float v = dst[i] * gainScale;
+        dst[i] = v > 32767.0f ? 32767.0f : (v < -32768.0f ? -32768.0f : v);
+    }
+}
+
+// 包络
+void computeEnvelope(const S16* samples, U32 n, U32 width, float gainScale,
+                     std::vector<float>& work, std::vector<float>& env) {
+    work.resize(n);
+    env.resize(n);
+    if (n == 0) {
+        return;
+    }
+    scaleSamples(samples, n, gainScale, work.data());
+    rectify(work.data(), n, sum(work.data(), n) / n);
+    if (width < 2) {
+        env = work;
+        return;
+    }
+    boxcar(work.data(), env.data(), n, width);
+    boxcar(env.data(), work.data(), n, width);
+    env.swap(work);
+}
+
+// 由设备参数得到分析设置
+EchoSettings EchoAnalyzer::settingsFromParams(const DEVICE_ULTRA_PARAM_U& params) {
+    const DEVICE_PARAM_S& p = params.stParam;
+    EchoSettings settings;
+    settings.gateStartUs = p.gate1Start.value * ECHO_GATE_UNIT_US;
+    settings.gateEndUs = p.gate1End.value * ECHO_GATE_UNIT_US;
+    settings.speedMps = p.ultraSpeed.value * ECHO_SPEED_UNIT_MPS;
+    settings.envelopeInput = p.waveType.value == ENVELOPE_WAVE;
+    settings.zeroPointUs = (settings.envelopeInput ? p.zeroPointEnvelope.value : p.zeroPointOrigin.value)
+                           * ECHO_ZERO_POINT_UNIT_US;
+    settings.zeroToPeak = p.measureMode.value == MEASURE_MANUAL &&
+                          p.manualMeasureMode.value == MANUAL_ZP_CONTROL_MODE;
+    settings.gainScale = 1.0f;
+    return settings;
+}
+
+// 找下一个回波：连续超过阈值的一段为一个回波，取段内最大值并做抛物线插值
+double EchoAnalyzer::findEcho(U32& begin, U32 end, float threshold, float& amp) const {
+    const float* env = m_envelope.data();
+    U32 i = begin;
+    while (i < end && env[i] < threshold) {
+        ++i;
+    }
+    if (i >= end) {
+        begin = end;
+        return -1.0;
+    }
+    U32 peak = i;
+    while (i < end && env[i] >= threshold) {
+        if (env[i] > env[peak]) peak = i;
+        ++i;
+    }
+    begin = i;
+    amp = env[peak];
+    double offset = 0.0;
+    if (peak > 0 && peak + 1 < m_envelope.size()) {
+        double left = env[peak - 1];
+        double right = env[peak + 1];
+        double denom = left - 2.0 * env[peak] + right;
+        if (denom < 0.0) {
+            offset = 0.5 * (left - right) / denom;
+        }
+    }
+    return peak + offset;
+}
+
+// 分析一个波形
+S32 EchoAnalyzer::analyze(const WaveBuffer& wave, const EchoSettings& settings, EchoResult& result) {
+    result = EchoResult();
+    result.deviceThicknessMm = wave.header().thick;
+    U32 n = wave.size();
+    double step = wave.timeStep();
+    if (n == 0 || step <= 0.0 || settings.speedMps <= 0.0 || settings.gateEndUs <= settings.gateStartUs) {
+        result.status = ECHO_RESULT_BAD_GATE;
+        return result.status;
+    }
+
+    // 平滑宽度取一个激励周期
+    double freqMHz = wave.header().excitation_freq > 0.0f ? wave.header().excitation_freq : ECHO_DEFAULT_FREQ_MHZ;
+    U32 width = settings.envelopeInput ? 1 : static_cast<U32>(1.0 / (freqMHz * step) + 0.5);
+    if (settings.envelopeInput) {
+        m_envelope.resize(n);
+        scaleSamples(wave.samples(), n, settings.gainScale, m_envelope.data());
+    } else {
+        computeEnvelope(wave.samples(), n, width, settings.gainScale, m_work, m_envelope);
+    }
+
+    // 闸门换算为采样点区间
+    double first = (settings.gateStartUs - wave.timeStart()) / step;
+    double last = (settings.gateEndUs - wave.timeStart()) / step;
+    U32 begin = first > 0.0 ? static_cast<U32>(first) : 0;
+    U32 end = last > 0.0 ? static_cast<U32>(std::ceil(last)) : 0;
+    if (end > n) end = n;
+    if (begin >= end) {
+        result.status = ECHO_RESULT_BAD_GATE;
+        return result.status;
+    }
+
+    float threshold = maxOf(m_envelope.data() + begin, end - begin) * ECHO_PEAK_THRESHOLD;
+    if (threshold <= 0.0f) {
+        result.status = ECHO_RESULT_NO_ECHO;
+        return result.status;
+    }
+    double echo1 = findEcho(begin, end, threshold, result.firstAmp);
+    if (echo1 < 0.0) {
+        result.status = ECHO_RESULT_NO_ECHO;
+        return result.status;
+    }
+    result.firstUs = wave.timeStart() + echo1 * step;
+
+    // 厚度 = 声速 × 传播时间 / 2，m/s × us = 1e-3 mm
+    double flightUs;
+    if (settings.zeroToPeak) {
+        flightUs = result.firstUs - settings.zeroPointUs;
+    } else {
+        double echo2 = findEcho(begin, end, threshold, result.secondAmp);
+        if (echo2 < 0.0) {
+            result.status = ECHO_RESULT_NO_ECHO;
+            return result.status;
+        }
+        result.secondUs = wave.timeStart() + echo2 * step;
+        flightUs = result.secondUs - result.firstUs;
+    }
+    result.thicknessMm = settings.speedMps * flightUs * 1e-3 / 2.0;
+    result.status = ECHO_RESULT_OK;
+    return result.status;
+}
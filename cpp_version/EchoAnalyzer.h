@@ -0,0 +1,77 @@
+#ifndef __ECHO_ANALYZER_H__
+#define __ECHO_ANALYZER_H__
+
+#include <cstdint>
+#include <vector>
+#include "paramDefine.h"
+#include "WaveBuffer.h"
+
+
+// 使用 C++ using 别名替代 typedef
+using U32 = uint32_t;
+using S32 = int32_t;
+
+// 参数换算（按设备参数的单位约定）
+constexpr double ECHO_GATE_UNIT_US = 0.1;       // 闸门开始/结束：0.1us
+constexpr double ECHO_ZERO_POINT_UNIT_US = 0.01; // 探头零点：100 代表 1us
+constexpr double ECHO_SPEED_UNIT_MPS = 0.1;      // 声速：0.1m/s
+constexpr float ECHO_PEAK_THRESHOLD = 0.5f;      // 回波判定阈值（相对闸门内包络最大值）
+constexpr double ECHO_DEFAULT_FREQ_MHZ = 2.5;    // 信息帧没有激励频率时按此估算平滑宽度
+
+// 分析结果状态
+constexpr S32 ECHO_RESULT_OK = 0;          // 找到所需回波
+constexpr S32 ECHO_RESULT_NO_ECHO = -1;    // 闸门内回波不足
+constexpr S32 ECHO_RESULT_BAD_GATE = -2;   // 闸门与波形时间轴没有交集或参数无效
+
+// 分析设置
+struct EchoSettings {
+    double gateStartUs;  // 闸门开始（us）
+    double gateEndUs;    // 闸门结束（us）
+    double speedMps;     // 声速（m/s）
+    double zeroPointUs;  // 探头零点（us），零点-回波模式使用
+    bool envelopeInput;  // 波形已是包络波（ENVELOPE_WAVE），不再求包络
+    bool zeroToPeak;     // 零点-回波模式，否则为回波-回波（PP）模式
+    float gainScale;     // 相对采集时增益的幅值倍数（离线重算增益时使用），按 S16 范围限幅
+};
+
+// 分析结果
+struct EchoResult {
+    S32 status;              // 结果状态
+    double firstUs;          // 一次回波位置（us，抛物线插值）
+    double secondUs;         // 二次回波位置（us），零点-回波模式为 0
+    float firstAmp;          // 一次回波包络幅值
+    float secondAmp;         // 二次回波包络幅值
+    double thicknessMm;      // 主机计算的厚度（mm）
+    float deviceThicknessMm; // 设备报告的厚度（mm）
+};
+
+// 采样点乘以 gainScale 后按 S16 范围限幅，转换为 float
+void scaleSamples(const S16* samples, U32 n, float gainScale, float* dst);
+
+// 包络：按增益缩放、去直流、全波整流后做两次宽度为 width 的滑动平均（三角窗低通），结果写入 env（n 项）
+void computeEnvelope(const S16* samples, U32 n, U32 width, float gainScale,
+                     std::vector<float>& work, std::vector<float>& env);
+
+// 回波分析：对重组后的波形求包络，在闸门 1 内找回波峰，按声速重新计算厚度，用于核对设备测量值。
+// 内部缓冲区复用，同一对象由一个线程使用
+class EchoAnalyzer {
+private:
+    std::vector<float> m_work;     // 中间结果
+    std::vector<float> m_envelope; // 最近一次分析的包络
+
+    // 从 begin 开始在 [begin, end) 内找下一个超过阈值的回波，返回峰值位置（插值后，单位为采样点），没有时返回负数
+    double findEcho(U32& begin, U32 end, float threshold, float& amp) const;
+
+public:
+    // 由设备参数得到分析设置
+    static EchoSettings settingsFromParams(const DEVICE_ULTRA_PARAM_U& params);
+
+    // 分析一个波形
+    S32 analyze(const WaveBuffer& wave, const EchoSettings& settings, EchoResult& result);
+
+    // 最近一次分析的包络（与波形采样点一一对应）
+    const std::vector<float>& envelope() const { return m_envelope; }
+};
+
+
+#endif /*__ECHO_ANALYZER_H__*/
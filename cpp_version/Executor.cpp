@@ -0,0 +1,266 @@
+#include <iostream>
+#include "Executor.h"
+
+
+// 构造函数
+SerialExecutor::SerialExecutor()
+    : m_state(std::make_shared<ExecutorState>()) {
+    m_workThread = std::thread(&SerialExecutor::workThreadFunc, m_state);
+}
+
+// 析构函数
+SerialExecutor::~SerialExecutor() {
+    {
+        std::lock_guard<std::mutex> guard(m_state->taskMutex);
+        m_state->running = false;
+    }
+    m_state->taskCondition.notify_one();
+
+    if (m_workThread.joinable()) {
+        if (m_workThread.get_id() == std::this_thread::get_id()) {
+            // 最后一个引用在自身任务中释放，不能等待自己，线程持有共享状态自行退出
+            m_workThread.detach();
+        } else {
+            m_workThread.join();
+        }
+    }
+}
+
+// 提交任务
+void SerialExecutor::post(ExecutorTask task) {
+    if (!task) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(m_state->taskMutex);
+        m_state->tasks.push_back(std::move(task));
+        m_state->pendingCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_state->taskCondition.notify_one();
+}
+
+// 工作线程函数
+void SerialExecutor::workThreadFunc(std::shared_ptr<ExecutorState> state) {
+    std::unique_lock<std::mutex> lock(state->taskMutex);
+    while (true) {
+        state->taskCondition.wait(lock, [&state] {
+            return !state->running || !state->tasks.empty();
+        });
+
+        // 停止且没有剩余任务时退出
+        if (state->tasks.empty()) {
+            break;
+        }
+
+        ExecutorTask task = std::move(state->tasks.front());
+        state->tasks.pop_front();
+        lock.unlock(); // 执行任务前解锁
+
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in executor task: " << e.what() << std::endl;
+        }
+        task = nullptr; // 在解锁状态下释放任务捕获的资源
+        state->pendingCount.fetch_sub(1, std::memory_order_relaxed);
+
+        lock.lock();
+    }
+}
+
+// 线程池构造函数
+WorkerPool::WorkerPool(U32 threadCount)
+    : m_running(true) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    for (U32 i = 0; i < threadCount; ++i) {
+        m_workThreads.emplace_back(&WorkerPool::workThreadFunc, this);
+    }
+}
+
+// 线程池析构函数
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> guard(m_taskMutex);
+        m_running = false;
+    }
+    m_taskCondition.notify_all();
+
+    for (auto& thread : m_workThreads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+// 提交任务
+void WorkerPool::post(ExecutorTask task) {
+    if (!task) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(m_taskMutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_taskCondition.notify_one();
+}
+
+// 工作线程函数
+void WorkerPool::workThreadFunc() {
+    std::unique_lock<std::mutex> lock(m_taskMutex);
+    while (true) {
+        m_taskCondition.wait(lock, [this] {
+            return !m_running || !m_tasks.empty();
+        });
+
+        // 停止且没有剩余任务时退出
+        if (m_tasks.empty()) {
+            break;
+        }
+
+        ExecutorTask task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        lock.unlock(); // 执行任务前解锁
+
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in worker pool task: " << e.what() << std::endl;
+        }
+        task = nullptr;
+
+        lock.lock();
+    }
+}
+
+// 当前线程所属的工作窃取线程池及其队列序号
+static thread_local WorkStealingPool* t_stealingPool = nullptr;
+static thread_local U32 t_stealingIndex = 0;
+
+// 工作窃取线程池构造函数
+WorkStealingPool::WorkStealingPool(U32 threadCount)
+    : m_queuedCount(0),
+      m_unfinishedCount(0),
+      m_nextQueue(0),
+      m_stealCount(0),
+      m_running(true) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) {
+            threadCount = 1;
+        }
+    }
+    for (U32 i = 0; i < threadCount; ++i) {
+        m_queues.emplace_back(new WorkQueue());
+    }
+    for (U32 i = 0; i < threadCount; ++i) {
+        m_workThreads.emplace_back(&WorkStealingPool::workThreadFunc, this, i);
+    }
+}
+
+// 工作窃取线程池析构函数
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> guard(m_idleMutex);
+        m_running = false;
+    }
+    m_idleCondition.notify_all();
+
+    for (auto& thread : m_workThreads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+// 提交任务
+void WorkStealingPool::post(ExecutorTask task) {
+    if (!task) {
+        return;
+    }
+    U32 index = t_stealingPool == this
+        ? t_stealingIndex
+        : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % static_cast<U32>(m_queues.size());
+    m_unfinishedCount.fetch_add(1, std::memory_order_relaxed);
+    m_queuedCount.fetch_add(1, std::memory_order_release); // 先计数，取任务时计数不会小于 0
+    {
+        std::lock_guard<std::mutex> guard(m_queues[index]->mutex);
+        m_queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        // 加锁后通知，避免与检查条件后即将等待的线程错过唤醒
+        std::lock_guard<std::mutex> guard(m_idleMutex);
+    }
+    m_idleCondition.notify_one();
+}
+
+// 等待全部任务完成
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(m_idleMutex);
+    m_doneCondition.wait(lock, [this] {
+        return m_unfinishedCount.load(std::memory_order_acquire) == 0;
+    });
+}
+
+// 取任务
+bool WorkStealingPool::takeTask(U32 index, ExecutorTask& task) {
+    {
+        WorkQueue& own = *m_queues[index];
+        std::lock_guard<std::mutex> guard(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            m_queuedCount.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    U32 count = static_cast<U32>(m_queues.size());
+    for (U32 i = 1; i < count; ++i) {
+        WorkQueue& victim = *m_queues[(index + i) % count];
+        std::lock_guard<std::mutex> guard(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_queuedCount.fetch_sub(1, std::memory_order_relaxed);
+            m_stealCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+// 工作线程函数
+void WorkStealingPool::workThreadFunc(U32 index) {
+    t_stealingPool = this;
+    t_stealingIndex = index;
+    ExecutorTask task;
+    while (true) {
+        if (takeTask(index, task)) {
+            try {
+                task();
+            } catch (const std::exception& e) {
+                std::cerr << "Exception in work stealing task: " << e.what() << std::endl;
+            }
+            task = nullptr;
+            if (m_unfinishedCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> guard(m_idleMutex);
+                m_doneCondition.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_idleMutex);
+        m_idleCondition.wait(lock, [this] {
+            return !m_running || m_queuedCount.load(std::memory_order_acquire) > 0;
+        });
+        // 停止且没有剩余任务时退出
+        if (!m_running && m_queuedCount.load(std::memory_order_acquire) == 0) {
+            break;
+        }
+    }
+    t_stealingPool = nullptr;
+}
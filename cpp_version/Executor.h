@@ -0,0 +1,141 @@
+#ifndef __EXECUTOR_H__
+#define __EXECUTOR_H__
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+
+// 使用 C++ using 别名替代 typedef
+using U32 = uint32_t;
+using U64 = uint64_t;
+
+// 任务类型
+using ExecutorTask = std::function<void()>;
+
+// 执行器共享状态：由执行器和工作线程共同持有，
+// 执行器在自身任务中被释放时，工作线程仍可安全退出
+struct ExecutorState {
+    std::deque<ExecutorTask> tasks;        // 待执行任务
+    std::mutex taskMutex;                  // 任务队列互斥锁
+    std::condition_variable taskCondition; // 任务到达条件变量
+    bool running{true};                    // 运行状态标志（受 taskMutex 保护）
+    std::atomic<U32> pendingCount{0};      // 未执行任务数
+};
+
+// 串行执行器：一个独立线程按提交顺序执行任务
+class SerialExecutor {
+private:
+    std::shared_ptr<ExecutorState> m_state; // 共享状态
+    std::thread m_workThread;               // 工作线程
+
+    // 工作线程函数
+    static void workThreadFunc(std::shared_ptr<ExecutorState> state);
+
+public:
+    // 构造函数，创建工作线程
+    SerialExecutor();
+
+    // 析构函数，执行完剩余任务后退出
+    ~SerialExecutor();
+
+    // 禁止拷贝构造和赋值操作
+    SerialExecutor(const SerialExecutor&) = delete;
+    SerialExecutor& operator=(const SerialExecutor&) = delete;
+
+    // 提交任务
+    void post(ExecutorTask task);
+
+    // 获取未执行任务数
+    U32 getPendingCount() const { return m_state->pendingCount.load(std::memory_order_relaxed); }
+};
+
+// 共享工作线程池：多个设备的调度器共用一组线程，按 CPU 核数扩展
+class WorkerPool {
+private:
+    std::deque<ExecutorTask> m_tasks;        // 待执行任务
+    std::mutex m_taskMutex;                  // 任务队列互斥锁
+    std::condition_variable m_taskCondition; // 任务到达条件变量
+    std::vector<std::thread> m_workThreads;  // 工作线程
+    bool m_running;                          // 运行状态标志（受 m_taskMutex 保护）
+
+    // 工作线程函数
+    void workThreadFunc();
+
+public:
+    // 构造函数，threadCount 为 0 时使用硬件线程数
+    explicit WorkerPool(U32 threadCount = 0);
+
+    // 析构函数，执行完剩余任务后退出
+    ~WorkerPool();
+
+    // 禁止拷贝构造和赋值操作
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // 提交任务
+    void post(ExecutorTask task);
+
+    // 获取工作线程数
+    U32 getThreadCount() const { return static_cast<U32>(m_workThreads.size()); }
+};
+
+// 工作窃取线程池：每个工作线程有自己的任务队列，线程内提交的任务放入本线程队列尾部并优先执行（后进先出），
+// 本线程队列为空时从其他线程队列头部窃取较早（通常较大）的任务。适合递归拆分的批量计算
+class WorkStealingPool {
+private:
+    // 单个工作线程的任务队列
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<ExecutorTask> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues; // 各工作线程的任务队列
+    std::vector<std::thread> m_workThreads;           // 工作线程
+    std::mutex m_idleMutex;                           // 空闲等待互斥锁
+    std::condition_variable m_idleCondition;          // 任务到达条件变量
+    std::condition_variable m_doneCondition;          // 全部任务完成条件变量
+    std::atomic<U32> m_queuedCount;                   // 队列中的任务数
+    std::atomic<U32> m_unfinishedCount;               // 已提交未完成的任务数
+    std::atomic<U32> m_nextQueue;                     // 外部提交轮转位置
+    std::atomic<U64> m_stealCount;                    // 窃取次数
+    bool m_running;                                   // 运行状态标志（受 m_idleMutex 保护）
+
+    // 取任务：先取本线程队列尾部，再窃取其他队列头部
+    bool takeTask(U32 index, ExecutorTask& task);
+
+    // 工作线程函数
+    void workThreadFunc(U32 index);
+
+public:
+    // 构造函数，threadCount 为 0 时使用硬件线程数
+    explicit WorkStealingPool(U32 threadCount = 0);
+
+    // 析构函数，执行完剩余任务后退出
+    ~WorkStealingPool();
+
+    // 禁止拷贝构造和赋值操作
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // 提交任务，在工作线程中调用时放入本线程队列
+    void post(ExecutorTask task);
+
+    // 等待已提交的任务（包括任务中再提交的任务）全部完成，不能在工作线程中调用
+    void wait();
+
+    // 获取工作线程数
+    U32 getThreadCount() const { return static_cast<U32>(m_workThreads.size()); }
+
+    // 获取窃取次数
+    U64 getStealCount() const { return m_stealCount.load(std::memory_order_relaxed); }
+};
+
+
+#endif /*__EXECUTOR_H__*/
@@ -0,0 +1,90 @@
+#ifndef __FRAME_AWAITER_H__
+#define __FRAME_AWAITER_H__
+
+// C++20 协程接口：在协程中等待帧或命令应答，例如
+//     FrameTask measure(EmatCommunicater& comm) {
+//         co_await comm.request({0x33, 0x55, 0x00, 0x00});
+//         auto frame = co_await comm.dispatcher().next(0x35, nullptr, 500);
+//         if (frame.empty()) { /* 超时 */ }
+//     }
+// 帧到达时协程在指定的恢复调度器上继续执行（默认在分发该帧的线程中直接恢复），
+// 等待期间不占用任何线程，少量线程即可同时驱动多台设备
+
+#include "AsyncFrame.h"
+
+#ifdef FRAME_AWAITER_AVAILABLE
+#include <coroutine>
+#include <exception>
+#include <iostream>
+
+// 分离式协程返回类型：启动后立即执行，结束时自动释放
+struct FrameTask {
+    struct promise_type {
+        FrameTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() {
+            try {
+                throw;
+            } catch (const std::exception& e) {
+                std::cerr << "Exception in frame task: " << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "Unknown exception in frame task" << std::endl;
+            }
+        }
+    };
+};
+
+// 登记等待的函数类型：收到参数中的回调后完成登记（并在需要时发送请求），帧到达或请求失败时调用回调
+using FrameArmFunction = std::function<void(FrameWaitCallback)>;
+
+// 等待一帧的可等待对象，co_await 的结果为帧数据（长度为帧有效长度），请求失败、超时、取消或分发器反初始化时为空
+class FrameAwaitable {
+private:
+    FrameArmFunction m_arm;        // 登记等待
+    ResumeScheduler m_scheduler;   // 恢复调度器，为空时在分发线程中直接恢复
+    std::vector<U8> m_result;      // 收到的帧
+
+public:
+    FrameAwaitable(FrameArmFunction arm, ResumeScheduler scheduler)
+        : m_arm(std::move(arm)),
+          m_scheduler(std::move(scheduler)) {
+    }
+
+    // 指定恢复调度器
+    FrameAwaitable& on(ResumeScheduler scheduler) {
+        m_scheduler = std::move(scheduler);
+        return *this;
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        ResumeScheduler scheduler = m_scheduler;
+        std::vector<U8>* result = &m_result;
+        // 登记之后 this 可能已随协程恢复而失效，只使用局部副本
+        FrameArmFunction arm = std::move(m_arm);
+        arm([handle, scheduler, result](const std::vector<U8>& frame, U32 len) {
+            result->assign(frame.begin(), frame.begin() + len);
+            if (scheduler) {
+                scheduler([handle]() { handle.resume(); });
+            } else {
+                handle.resume();
+            }
+        });
+    }
+
+    std::vector<U8> await_resume() { return std::move(m_result); }
+};
+
+// 等待下一帧指定类型的帧，timeoutMs 不为 0 时超时恢复并得到空帧
+inline FrameAwaitable AsyncFrameDispatcher::next(U8 frameType, FrameFilter filter, U32 timeoutMs) {
+    return FrameAwaitable([this, frameType, filter, timeoutMs](FrameWaitCallback callback) {
+        waitFrame(frameType, filter, std::move(callback), timeoutMs);
+    }, getResumeScheduler());
+}
+
+#endif
+
+#endif /*__FRAME_AWAITER_H__*/
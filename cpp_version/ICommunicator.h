@@ -4,6 +4,7 @@
 #include <functional>
 #include <atomic>
 #include <queue>
+#include "LatencyHistogram.h"
 // 使用 C++ 类型别名
 typedef uint8_t   U8;
 typedef uint32_t  U32;
@@ -38,5 +39,11 @@ public:
     virtual void setDataReceivedCallback(std::function<S32(const std::vector<U8>&, S32)> callback) = 0;
     virtual void setDataSentCallback(std::function<void(const std::vector<U8>&, S32)> callback) = 0;
 
+    // 设置接收许可回调：返回 false 时接收线程暂停读取，数据留在系统缓冲区中，
+    // 缓冲区满后串口由硬件流控、TCP 由接收窗口通知对端暂停发送
+    virtual void setReceiveCreditCallback(std::function<bool()> callback) { m_canReceive = std::move(callback); }
+
     std::atomic<bool> m_isOpen{ false }; // 通信是否打开
+    std::function<bool()> m_canReceive;  // 接收许可回调
+    std::atomic<U64> m_lastReadTime{ 0 }; // 最近一次系统读取完成的时间（单调时钟 ns），在接收回调中有效
 };
\ No newline at end of file
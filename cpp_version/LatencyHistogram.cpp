@@ -0,0 +1,173 @@
+#include "LatencyHistogram.h"
+
+
+// 构造函数
+LatencyHistogram::LatencyHistogram()
+    : m_count(0),
+      m_sum(0),
+      m_max(0) {
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+// 计算值所在的桶：小于 8 的值每个值一个桶，其余按最高位分组后取其下 3 位作为子桶
+U32 LatencyHistogram::bucketIndex(U64 value) {
+    if (value < LATENCY_SUB_BUCKETS) {
+        return static_cast<U32>(value);
+    }
+    U32 msb = 63;
+    while (!(value >> msb)) {
+        --msb;
+    }
+    if (msb >= LATENCY_MAX_EXPONENT) {
+        return LATENCY_BUCKET_COUNT - 1;
+    }
+    U32 exponent = msb - LATENCY_SUB_BUCKET_BITS + 1;
+    U32 sub = static_cast<U32>(value >> (msb - LATENCY_SUB_BUCKET_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+    return exponent * LATENCY_SUB_BUCKETS + sub;
+}
+
+// 桶的上界（不含）
+U64 LatencyHistogram::bucketUpperBound(U32 index) {
+    if (index < LATENCY_SUB_BUCKETS) {
+        return index + 1;
+    }
+    U32 exponent = index / LATENCY_SUB_BUCKETS;
+    U32 sub = index % LATENCY_SUB_BUCKETS;
+    return static_cast<U64>(LATENCY_SUB_BUCKETS + sub + 1) << (exponent - 1);
+}
+
+// 记录一个样本
+void LatencyHistogram::record(U64 value) {
+    m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    U64 current = m_max.load(std::memory_order_relaxed);
+    while (value > current && !m_max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+// 获取快照
+LatencySnapshot LatencyHistogram::snapshot() const {
+    LatencySnapshot result;
+    std::array<U32, LATENCY_BUCKET_COUNT> counts;
+    U64 total = 0;
+    for (U32 i = 0; i < LATENCY_BUCKET_COUNT; ++i) {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    result.count = total;
+    result.max = m_max.load(std::memory_order_relaxed);
+    if (total == 0) {
+        return result;
+    }
+    result.mean = static_cast<double>(m_sum.load(std::memory_order_relaxed)) / static_cast<double>(total);
+
+    // 分位数对应的样本序号（向上取整）
+    const U64 rank50 = (total * 500 + 999) / 1000;
+    const U64 rank99 = (total * 990 + 999) / 1000;
+    const U64 rank999 = (total * 999 + 999) / 1000;
+    U64 seen = 0;
+    for (U32 i = 0; i < LATENCY_BUCKET_COUNT; ++i) {
+        if (counts[i] == 0) {
+            continue;
+        }
+        seen += counts[i];
+        U64 bound = bucketUpperBound(i);
+        if (bound > result.max) {
+            bound = result.max;
+        }
+        if (result.p50 == 0 && seen >= rank50) {
+            result.p50 = bound;
+        }
+        if (result.p99 == 0 && seen >= rank99) {
+            result.p99 = bound;
+        }
+        if (result.p999 == 0 && seen >= rank999) {
+            result.p999 = bound;
+            break;
+        }
+    }
+    return result;
+}
+
+// 清零
+void LatencyHistogram::reset() {
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+// 构造函数
+FrameLatencyStats::FrameLatencyStats() {
+    for (auto& set : m_sets) {
+        set.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+// 析构函数
+FrameLatencyStats::~FrameLatencyStats() {
+    for (auto& set : m_sets) {
+        delete set.load(std::memory_order_relaxed);
+    }
+}
+
+// 获取（必要时创建）某类帧的直方图组
+FrameLatencyStats::StageSet& FrameLatencyStats::acquireSet(U8 frameType) {
+    StageSet* set = m_sets[frameType].load(std::memory_order_acquire);
+    if (set == nullptr) {
+        StageSet* created = new StageSet();
+        if (m_sets[frameType].compare_exchange_strong(set, created, std::memory_order_acq_rel)) {
+            set = created;
+        } else {
+            delete created; // 其他线程已创建
+        }
+    }
+    return *set;
+}
+
+// 记录一帧的各阶段延迟，未记录的时间戳跳过对应阶段
+void FrameLatencyStats::record(U8 frameType, const FrameTiming& timing, U64 handlerStart, U64 handlerEnd) {
+    StageSet& set = acquireSet(frameType);
+    auto stage = [&set](LatencyStage s) -> LatencyHistogram& {
+        return set.stages[static_cast<U32>(s)];
+    };
+    if (timing.rxTime != 0 && timing.parsedTime >= timing.rxTime) {
+        stage(LatencyStage::WIRE_TO_PARSE).record(timing.parsedTime - timing.rxTime);
+    }
+    if (timing.parsedTime != 0 && timing.enqueueTime >= timing.parsedTime) {
+        stage(LatencyStage::PARSE_TO_ENQUEUE).record(timing.enqueueTime - timing.parsedTime);
+    }
+    if (timing.enqueueTime != 0 && handlerStart >= timing.enqueueTime) {
+        stage(LatencyStage::QUEUE_WAIT).record(handlerStart - timing.enqueueTime);
+    }
+    stage(LatencyStage::HANDLER).record(handlerEnd - handlerStart);
+    if (timing.rxTime != 0 && handlerEnd >= timing.rxTime) {
+        stage(LatencyStage::TOTAL).record(handlerEnd - timing.rxTime);
+    }
+}
+
+// 获取某类帧某阶段的快照
+LatencySnapshot FrameLatencyStats::snapshot(U8 frameType, LatencyStage stage) const {
+    const StageSet* set = m_sets[frameType].load(std::memory_order_acquire);
+    if (set == nullptr || stage >= LatencyStage::COUNT) {
+        return LatencySnapshot();
+    }
+    return set->stages[static_cast<U32>(stage)].snapshot();
+}
+
+// 清零全部直方图
+void FrameLatencyStats::reset() {
+    for (auto& set : m_sets) {
+        StageSet* current = set.load(std::memory_order_acquire);
+        if (current != nullptr) {
+            for (auto& histogram : current->stages) {
+                histogram.reset();
+            }
+        }
+    }
+}
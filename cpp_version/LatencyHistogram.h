@@ -0,0 +1,119 @@
+#ifndef __LATENCY_HISTOGRAM_H__
+#define __LATENCY_HISTOGRAM_H__
+
+#include <cstdint>
+#include <atomic>
+#include <array>
+#include <chrono>
+
+
+// 使用 C++ using 别名替代 typedef
+using U8 = uint8_t;
+using U32 = uint32_t;
+using U64 = uint64_t;
+
+// 对数线性直方图参数：每个 2 的幂区间再均分 8 个子桶，相对误差不超过 12.5%
+constexpr U32 LATENCY_SUB_BUCKET_BITS = 3;
+constexpr U32 LATENCY_SUB_BUCKETS = 1u << LATENCY_SUB_BUCKET_BITS;
+constexpr U32 LATENCY_MAX_EXPONENT = 40;  // 覆盖到 2^40 ns（约 18 分钟），更大的值计入最后一个桶
+constexpr U32 LATENCY_BUCKET_COUNT = (LATENCY_MAX_EXPONENT - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS;
+constexpr U32 LATENCY_FRAME_TYPES = 256;  // 帧类型数
+
+// 单调时钟，单位纳秒
+inline U64 monotonicNowNs() {
+    return static_cast<U64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// 帧在接收流水线各阶段的时间戳（单调时钟 ns，0 表示未记录）
+struct FrameTiming {
+    U64 rxTime{0};       // 传输层完成系统读取
+    U64 parsedTime{0};   // 解析器提取出完整帧
+    U64 enqueueTime{0};  // 放入调度队列
+    U64 alignedTime{0};  // 主机对齐时间：设备发出该帧的时刻换算到主机单调时钟（由帧时钟函数给出）
+};
+
+// 流水线阶段
+enum class LatencyStage : U8 {
+    WIRE_TO_PARSE,     // 系统读取 -> 帧完整
+    PARSE_TO_ENQUEUE,  // 帧完整 -> 入队
+    QUEUE_WAIT,        // 入队 -> 处理函数开始
+    HANDLER,           // 处理函数开始 -> 结束
+    TOTAL,             // 系统读取 -> 处理函数结束
+    COUNT
+};
+constexpr U32 LATENCY_STAGE_COUNT = static_cast<U32>(LatencyStage::COUNT);
+
+// 直方图快照（单位 ns）
+struct LatencySnapshot {
+    U64 count{0};
+    U64 p50{0};
+    U64 p99{0};
+    U64 p999{0};
+    U64 max{0};
+    double mean{0.0};
+};
+
+// 无锁对数线性直方图：记录只做原子加，可在任意线程并发调用
+class LatencyHistogram {
+private:
+    std::array<std::atomic<U32>, LATENCY_BUCKET_COUNT> m_buckets; // 各桶计数
+    std::atomic<U64> m_count;  // 总样本数
+    std::atomic<U64> m_sum;    // 样本总和
+    std::atomic<U64> m_max;    // 最大值
+
+    // 计算值所在的桶
+    static U32 bucketIndex(U64 value);
+
+    // 桶的上界（不含）
+    static U64 bucketUpperBound(U32 index);
+
+public:
+    LatencyHistogram();
+
+    // 禁止拷贝构造和赋值操作
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    // 记录一个样本
+    void record(U64 value);
+
+    // 获取快照，分位数取所在桶的上界
+    LatencySnapshot snapshot() const;
+
+    // 清零
+    void reset();
+};
+
+// 按帧类型和阶段分组的延迟统计，某类帧首次出现时才分配直方图
+class FrameLatencyStats {
+private:
+    // 一种帧类型的各阶段直方图
+    struct StageSet {
+        std::array<LatencyHistogram, LATENCY_STAGE_COUNT> stages;
+    };
+    std::array<std::atomic<StageSet*>, LATENCY_FRAME_TYPES> m_sets;
+
+    // 获取（必要时创建）某类帧的直方图组
+    StageSet& acquireSet(U8 frameType);
+
+public:
+    FrameLatencyStats();
+    ~FrameLatencyStats();
+
+    // 禁止拷贝构造和赋值操作
+    FrameLatencyStats(const FrameLatencyStats&) = delete;
+    FrameLatencyStats& operator=(const FrameLatencyStats&) = delete;
+
+    // 记录一帧的各阶段延迟
+    void record(U8 frameType, const FrameTiming& timing, U64 handlerStart, U64 handlerEnd);
+
+    // 获取某类帧某阶段的快照
+    LatencySnapshot snapshot(U8 frameType, LatencyStage stage) const;
+
+    // 清零全部直方图
+    void reset();
+};
+
+
+#endif /*__LATENCY_HISTOGRAM_H__*/
@@ -0,0 +1,67 @@
+#include "MinMaxPyramid.h"
+#include "SimdConfig.h"
+#if defined(SIMD_AVX2) || defined(SIMD_SSE2)
+#include <emmintrin.h>
+#define MIN_MAX_SSE2
+#endif
+
+
+#ifdef MIN_MAX_SSE2
+// 8 个 16 位数中取偶数位置的 4 个，符号扩展为 32 位
+static inline __m128i evenS16(__m128i v) {
+    return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+}
+
+// 16 个相邻数两两合并为 8 个
+static inline __m128i pairMinS16(__m128i lo, __m128i hi) {
+    __m128i a = _mm_min_epi16(lo, _mm_srli_si128(lo, 2));
+    __m128i b = _mm_min_epi16(hi, _mm_srli_si128(hi, 2));
+    return _mm_packs_epi32(evenS16(a), evenS16(b));
+}
+
+static inline __m128i pairMaxS16(__m128i lo, __m128i hi) {
+    __m128i a = _mm_max_epi16(lo, _mm_srli_si128(lo, 2));
+    __m128i b = _mm_max_epi16(hi, _mm_srli_si128(hi, 2));
+    return _mm_packs_epi32(evenS16(a), evenS16(b));
+}
+#endif
+
+// S16 相邻两项合并
+void reduceMinMaxPairs(const S16* srcMin, const S16* srcMax, U32 pairs, S16* dstMin, S16* dstMax) {
+    U32 i = 0;
+#ifdef MIN_MAX_SSE2
+    for (; i + 8 <= pairs; i += 8) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcMin + 2 * i));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcMin + 2 * i + 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstMin + i), pairMinS16(lo, hi));
+        lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcMax + 2 * i));
+        hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcMax + 2 * i + 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstMax + i), pairMaxS16(lo, hi));
+    }
+#endif
+    for (; i < pairs; ++i) {
+        dstMin[i] = srcMin[2 * i] < srcMin[2 * i + 1] ? srcMin[2 * i] : srcMin[2 * i + 1];
+        dstMax[i] = srcMax[2 * i] > srcMax[2 * i + 1] ? srcMax[2 * i] : srcMax[2 * i + 1];
+    }
+}
+
+// float 相邻两项合并
+void reduceMinMaxPairs(const float* srcMin, const float* srcMax, U32 pairs, float* dstMin, float* dstMax) {
+    U32 i = 0;
+#ifdef MIN_MAX_SSE2
+    for (; i + 4 <= pairs; i += 4) {
+        __m128 lo = _mm_loadu_ps(srcMin + 2 * i);
+        __m128 hi = _mm_loadu_ps(srcMin + 2 * i + 4);
+        _mm_storeu_ps(dstMin + i, _mm_min_ps(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)),
+                                             _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1))));
+        lo = _mm_loadu_ps(srcMax + 2 * i);
+        hi = _mm_loadu_ps(srcMax + 2 * i + 4);
+        _mm_storeu_ps(dstMax + i, _mm_max_ps(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)),
+                                             _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1))));
+    }
+#endif
+    for (; i < pairs; ++i) {
+        dstMin[i] = srcMin[2 * i] < srcMin[2 * i + 1] ? srcMin[2 * i] : srcMin[2 * i + 1];
+        dstMax[i] = srcMax[2 * i] > srcMax[2 * i + 1] ? srcMax[2 * i] : srcMax[2 * i + 1];
+    }
+}
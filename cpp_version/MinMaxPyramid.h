@@ -0,0 +1,191 @@
+#ifndef __MIN_MAX_PYRAMID_H__
+#define __MIN_MAX_PYRAMID_H__
+
+#include <cstdint>
+#include <vector>
+
+
+// 使用 C++ using 别名替代 typedef
+using U32 = uint32_t;
+using U64 = uint64_t;
+using S16 = int16_t;
+
+// 一段数据的最小值和最大值
+template <typename T>
+struct MinMaxPair {
+    T min;
+    T max;
+};
+
+// 相邻两项合并为一项：dst[i] = min/max(src[2i], src[2i+1])，共 pairs 项
+void reduceMinMaxPairs(const S16* srcMin, const S16* srcMax, U32 pairs, S16* dstMin, S16* dstMax);
+void reduceMinMaxPairs(const float* srcMin, const float* srcMax, U32 pairs, float* dstMin, float* dstMax);
+
+// 最小/最大值金字塔：第 0 层为原始数据，第 L 层每项覆盖 2^L 个数据，随数据追加逐层增量更新。
+// 任意区间的精确最小/最大值由 O(log n) 个对齐块合成，按像素取包络为 O(像素数 × log n)，与数据量无关。
+// 设置容量（2 的幂）时，数据达到容量后丢弃较早的一半，各层同步平移，数据按绝对序号访问。
+// 非线程安全，由调用者加锁
+template <typename T>
+class MinMaxPyramid {
+private:
+    std::vector<std::vector<T>> m_min; // 各层最小值，第 0 层为原始数据
+    std::vector<std::vector<T>> m_max; // 各层最大值，第 0 层不使用
+    U64 m_base;                        // 第 0 层首项的绝对序号
+    U32 m_capacity;                    // 数据容量，0 表示不限
+    U32 m_maxLevels;                   // 层数上限
+
+    const T* minOf(U32 level) const { return m_min[level].data(); }
+    const T* maxOf(U32 level) const { return level == 0 ? m_min[0].data() : m_max[level].data(); }
+
+    // 合并第 level-1 层新增的完整对到第 level 层
+    void propagate(U32 level) {
+        U32 pairs = static_cast<U32>(m_min[level - 1].size() / 2);
+        U32 done = static_cast<U32>(m_min[level].size());
+        if (pairs == done) {
+            return;
+        }
+        m_min[level].resize(pairs);
+        m_max[level].resize(pairs);
+        reduceMinMaxPairs(minOf(level - 1) + 2 * done, maxOf(level - 1) + 2 * done, pairs - done,
+                          m_min[level].data() + done, m_max[level].data() + done);
+    }
+
+    // 丢弃较早的一半数据，丢弃数在每层都是整块
+    void trim() {
+        U32 drop = m_capacity / 2;
+        for (U32 level = 0; level < m_min.size(); ++level) {
+            U32 count = drop >> level;
+            m_min[level].erase(m_min[level].begin(), m_min[level].begin() + count);
+            if (level > 0) {
+                m_max[level].erase(m_max[level].begin(), m_max[level].begin() + count);
+            }
+        }
+        m_base += drop;
+    }
+
+    void include(MinMaxPair<T>& result, bool& found, U32 level, U32 index) const {
+        T lo = minOf(level)[index];
+        T hi = maxOf(level)[index];
+        if (!found) {
+            result = {lo, hi};
+            found = true;
+            return;
+        }
+        if (lo < result.min) result.min = lo;
+        if (hi > result.max) result.max = hi;
+    }
+
+public:
+    // capacity 为 0 或 2 的幂；reserve 为预分配的数据数，之后在此范围内追加不再分配内存
+    explicit MinMaxPyramid(U32 capacity = 0, U32 reserve = 0)
+        : m_base(0),
+          m_capacity(capacity),
+          m_maxLevels(32) {
+        if (m_capacity >= 2) {
+            m_maxLevels = 0;
+            while ((4u << m_maxLevels) <= m_capacity) {
+                ++m_maxLevels; // 最高层每项覆盖 capacity/2 个数据
+            }
+            if (reserve < m_capacity) {
+                reserve = m_capacity;
+            }
+        }
+        m_min.resize(1);
+        m_max.resize(1);
+        m_min[0].reserve(reserve);
+        for (U32 level = 1; level <= m_maxLevels && (reserve >> level) > 0; ++level) {
+            m_min.emplace_back();
+            m_max.emplace_back();
+            m_min[level].reserve(reserve >> level);
+            m_max[level].reserve(reserve >> level);
+        }
+    }
+
+    // 清空数据，保留已分配的内存
+    void clear() {
+        for (auto& level : m_min) level.clear();
+        for (auto& level : m_max) level.clear();
+        m_base = 0;
+    }
+
+    // 追加数据并逐层更新
+    void append(const T* data, U32 count) {
+        while (count > 0) {
+            U32 chunk = count;
+            if (m_capacity != 0) {
+                if (m_min[0].size() >= m_capacity) {
+                    trim();
+                }
+                U32 room = m_capacity - static_cast<U32>(m_min[0].size());
+                chunk = count < room ? count : room;
+            }
+            m_min[0].insert(m_min[0].end(), data, data + chunk);
+            data += chunk;
+            count -= chunk;
+            for (U32 level = 1; level <= m_maxLevels && m_min[level - 1].size() >= 2; ++level) {
+                if (level == m_min.size()) {
+                    m_min.emplace_back();
+                    m_max.emplace_back();
+                }
+                propagate(level);
+            }
+        }
+    }
+    void append(T value) { append(&value, 1); }
+
+    // 数据的绝对序号范围 [begin, end)
+    U64 begin() const { return m_base; }
+    U64 end() const { return m_base + m_min[0].size(); }
+    U32 size() const { return static_cast<U32>(m_min[0].size()); }
+
+    // 区间 [first, last) 的精确最小/最大值，区间与数据没有交集时返回 false
+    bool range(U64 first, U64 last, MinMaxPair<T>& result) const {
+        if (first < begin()) first = begin();
+        if (last > end()) last = end();
+        if (first >= last) {
+            return false;
+        }
+        U32 a = static_cast<U32>(first - m_base);
+        U32 b = static_cast<U32>(last - m_base);
+        bool found = false;
+        // 自底向上：区间两端不成对的项直接合并，其余部分上移一层
+        for (U32 level = 0; a < b; ++level) {
+            if (level + 1 >= m_min.size()) {
+                for (U32 i = a; i < b; ++i) {
+                    include(result, found, level, i);
+                }
+                break;
+            }
+            if (a & 1) include(result, found, level, a++);
+            if (b & 1) include(result, found, level, --b);
+            a >>= 1;
+            b >>= 1;
+        }
+        return found;
+    }
+
+    // 把 [first, last) 均分为 pixels 段，返回每段的最小/最大值（不足一个数据的段取所在的那个数据）；
+    // 每段由 O(log n) 个对齐块合成，总开销 O(pixels × log n)，不是 O(pixels)
+    U32 envelope(U64 first, U64 last, U32 pixels, std::vector<MinMaxPair<T>>& out) const {
+        out.clear();
+        if (first < begin()) first = begin();
+        if (last > end()) last = end();
+        if (first >= last || pixels == 0) {
+            return 0;
+        }
+        out.resize(pixels);
+        U64 span = last - first;
+        for (U32 p = 0; p < pixels; ++p) {
+            U64 a = first + span * p / pixels;
+            U64 b = first + span * (p + 1) / pixels;
+            if (b <= a) {
+                b = a + 1;
+            }
+            range(a, b, out[p]);
+        }
+        return pixels;
+    }
+};
+
+
+#endif /*__MIN_MAX_PYRAMID_H__*/
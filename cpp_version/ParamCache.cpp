@@ -0,0 +1,130 @@
+#include "ParamCache.h"
+
+
+// 参数打包为一个字：高 16 位序号，低 16 位值
+static U32 packParam(const PARAM_STRUCT_S& param) {
+    return (static_cast<U32>(param.index) << 16) | static_cast<U16>(param.value);
+}
+
+// 构造函数
+ParamCache::ParamCache()
+    : m_sequence(0) {
+    for (U32 i = 0; i < PARAM_SIZE; ++i) {
+        m_words[i].store(i << 16, std::memory_order_relaxed);
+        m_dirtyTimes[i].store(0, std::memory_order_relaxed);
+        m_confirmedTimes[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+// 开始写入：顺序号变为奇数，之后的数据写入不会被重排到它之前
+void ParamCache::beginWrite() {
+    m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+// 结束写入：顺序号变为偶数，发布本次写入的数据
+void ParamCache::endWrite() {
+    m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// 设置初始值
+void ParamCache::reset(const DEVICE_ULTRA_PARAM_U& params) {
+    std::lock_guard<std::mutex> guard(m_writeMutex);
+    beginWrite();
+    for (U32 i = 0; i < PARAM_SIZE; ++i) {
+        m_words[i].store(packParam(params.arrParam[i]), std::memory_order_relaxed);
+        m_dirtyTimes[i].store(0, std::memory_order_relaxed);
+        m_confirmedTimes[i].store(0, std::memory_order_relaxed);
+    }
+    endWrite();
+}
+
+// 设备确认了全部参数，序号保持不变
+void ParamCache::confirmAll(const DEVICE_ULTRA_PARAM_U& params, U64 nowNs) {
+    std::lock_guard<std::mutex> guard(m_writeMutex);
+    beginWrite();
+    for (U32 i = 0; i < PARAM_SIZE; ++i) {
+        U32 word = m_words[i].load(std::memory_order_relaxed);
+        m_words[i].store((word & 0xFFFF0000u) | static_cast<U16>(params.arrParam[i].value), std::memory_order_relaxed);
+        m_dirtyTimes[i].store(0, std::memory_order_relaxed);
+        m_confirmedTimes[i].store(nowNs, std::memory_order_relaxed);
+    }
+    endWrite();
+}
+
+// 设备确认了单个参数
+void ParamCache::confirm(U32 index, INT16 value, U64 nowNs) {
+    if (index >= PARAM_SIZE) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(m_writeMutex);
+    beginWrite();
+    U32 word = m_words[index].load(std::memory_order_relaxed);
+    m_words[index].store((word & 0xFFFF0000u) | static_cast<U16>(value), std::memory_order_relaxed);
+    m_dirtyTimes[index].store(0, std::memory_order_relaxed);
+    m_confirmedTimes[index].store(nowNs, std::memory_order_relaxed);
+    endWrite();
+}
+
+// 本地发起了写入
+void ParamCache::markDirty(U32 index, U64 nowNs) {
+    if (index < PARAM_SIZE) {
+        m_dirtyTimes[index].store(nowNs, std::memory_order_release);
+    }
+}
+
+// 写入失败，清除未确认标记
+void ParamCache::clearDirty(U32 index) {
+    if (index < PARAM_SIZE) {
+        m_dirtyTimes[index].store(0, std::memory_order_release);
+    }
+}
+
+// 读取一致的参数组快照
+void ParamCache::snapshot(DEVICE_ULTRA_PARAM_U& params, U64* generation) const {
+    U64 begin;
+    U64 end;
+    do {
+        begin = m_sequence.load(std::memory_order_acquire);
+        for (U32 i = 0; i < PARAM_SIZE; ++i) {
+            U32 word = m_words[i].load(std::memory_order_relaxed);
+            params.arrParam[i].index = static_cast<UINT16>(word >> 16);
+            params.arrParam[i].value = static_cast<INT16>(word & 0xFFFF);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        end = m_sequence.load(std::memory_order_relaxed);
+    } while ((begin & 1) != 0 || begin != end); // 写入中或读取期间有更新，重读
+    if (generation != nullptr) {
+        *generation = begin / 2;
+    }
+}
+
+// 读取单个参数（单个字的读取本身是原子的，不需要顺序号）
+INT16 ParamCache::value(U32 index) const {
+    if (index >= PARAM_SIZE) {
+        return 0;
+    }
+    return static_cast<INT16>(m_words[index].load(std::memory_order_acquire) & 0xFFFF);
+}
+
+// 读取单个参数的缓存状态
+ParamState ParamCache::state(U32 index) const {
+    ParamState result{0, 0, 0};
+    if (index < PARAM_SIZE) {
+        result.value = value(index);
+        result.dirtyTime = m_dirtyTimes[index].load(std::memory_order_acquire);
+        result.confirmedTime = m_confirmedTimes[index].load(std::memory_order_acquire);
+    }
+    return result;
+}
+
+// 参数是否新鲜
+bool ParamCache::isFresh(U32 index, U64 maxAgeNs, U64 nowNs) const {
+    if (index >= PARAM_SIZE) {
+        return false;
+    }
+    U64 confirmedTime = m_confirmedTimes[index].load(std::memory_order_acquire);
+    return confirmedTime != 0 &&
+           m_dirtyTimes[index].load(std::memory_order_acquire) == 0 &&
+           nowNs - confirmedTime <= maxAgeNs;
+}
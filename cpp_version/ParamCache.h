@@ -0,0 +1,77 @@
+#ifndef __PARAM_CACHE_H__
+#define __PARAM_CACHE_H__
+
+#include <cstdint>
+#include <atomic>
+#include <array>
+#include <mutex>
+#include "paramDefine.h"
+
+
+// 使用 C++ using 别名替代 typedef
+using U16 = uint16_t;
+using U32 = uint32_t;
+using U64 = uint64_t;
+
+// 单个参数的缓存状态
+struct ParamState {
+    INT16 value;         // 缓存值
+    U64 dirtyTime;       // 本地发起写入的时间（单调时钟 ns），0 表示没有未确认的写入
+    U64 confirmedTime;   // 最近一次由设备确认（读取应答或写入应答）的时间，0 表示从未确认
+};
+
+// 带版本号的设备参数缓存（顺序锁）：
+// 写入方（帧处理线程）整组更新时版本号先变为奇数、写完再变为偶数，
+// 读取方不加锁，读到奇数或前后版本号不一致时重读，因此不会读到更新一半的参数组，也不会阻塞写入方
+class ParamCache {
+private:
+    std::atomic<U64> m_sequence;                               // 顺序号，奇数表示正在写入
+    std::array<std::atomic<U32>, PARAM_SIZE> m_words;          // 各参数（高 16 位序号，低 16 位值）
+    std::array<std::atomic<U64>, PARAM_SIZE> m_dirtyTimes;     // 各参数未确认写入的发起时间
+    std::array<std::atomic<U64>, PARAM_SIZE> m_confirmedTimes; // 各参数最近确认时间
+    std::mutex m_writeMutex;                                   // 写入方互斥锁（读取方不使用）
+
+    // 开始/结束一次写入（需持有 m_writeMutex）
+    void beginWrite();
+    void endWrite();
+
+public:
+    ParamCache();
+
+    // 禁止拷贝构造和赋值操作
+    ParamCache(const ParamCache&) = delete;
+    ParamCache& operator=(const ParamCache&) = delete;
+
+    // 设置初始值（默认参数，未经设备确认）
+    void reset(const DEVICE_ULTRA_PARAM_U& params);
+
+    // 设备确认了全部参数（读取全部参数的应答）
+    void confirmAll(const DEVICE_ULTRA_PARAM_U& params, U64 nowNs);
+
+    // 设备确认了单个参数
+    void confirm(U32 index, INT16 value, U64 nowNs);
+
+    // 本地发起了写入，在确认前该参数视为不新鲜
+    void markDirty(U32 index, U64 nowNs);
+
+    // 写入失败，清除未确认标记（缓存值保持为设备最近确认的值）
+    void clearDirty(U32 index);
+
+    // 读取一致的参数组快照，generation 为该快照的版本号
+    void snapshot(DEVICE_ULTRA_PARAM_U& params, U64* generation = nullptr) const;
+
+    // 读取单个参数
+    INT16 value(U32 index) const;
+
+    // 读取单个参数的缓存状态
+    ParamState state(U32 index) const;
+
+    // 参数在 maxAgeNs 内经设备确认且没有未确认的写入时为新鲜，可直接使用缓存值而不访问设备
+    bool isFresh(U32 index, U64 maxAgeNs, U64 nowNs) const;
+
+    // 当前版本号，每次更新加 1
+    U64 generation() const { return m_sequence.load(std::memory_order_acquire) / 2; }
+};
+
+
+#endif /*__PARAM_CACHE_H__*/
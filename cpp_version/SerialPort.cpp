@@ -15,7 +15,8 @@ SerialPort::SerialPort(U32 recvBufSize, U32 sendBufSize)
       m_eventWrite(nullptr),
       m_workingThreadId(0),
       m_timeoutMilliSeconds(0),
-      m_totalByteCount(0) {
+      m_totalByteCount(0),
+      m_hwFlowControl(false) {
     
     // 初始化重叠IO结构
     ZeroMemory(&m_overlappedRead, sizeof(OVERLAPPED));
@@ -177,6 +178,11 @@ CommunicatorResult SerialPort::open(std::string comPort, S32 baudRate, S32 timeo
     portSettings.ByteSize = 8;
     portSettings.Parity = NOPARITY;
     portSettings.StopBits = ONESTOPBIT;
+    if (m_hwFlowControl) {
+        // 接收缓冲区接近满时驱动自动拉低 RTS，对端暂停发送
+        portSettings.fOutxCtsFlow = TRUE;
+        portSettings.fRtsControl = RTS_CONTROL_HANDSHAKE;
+    }
     
     if (!SetCommState(m_portHandle, &portSettings)) {
         std::cerr << "Error: Failed to set serial port state" << std::endl;
@@ -353,6 +359,12 @@ DWORD WINAPI SerialPort::waitForDataThread(LPVOID lpParam) {
     DWORD bytesRead = 0;
     
     while (sp->m_isOpen.load()) {
+        // 下游没有接收许可时暂停读取，数据留在驱动缓冲区中
+        if (sp->m_canReceive && !sp->m_canReceive()) {
+            Sleep(SERIALPORT_INTERNAL_TIMEOUT);
+            continue;
+        }
+
         // 重置事件
         ResetEvent(sp->m_eventRead);
         
@@ -375,6 +387,11 @@ DWORD WINAPI SerialPort::waitForDataThread(LPVOID lpParam) {
             }
         }
         
+        // 记录读取完成时间，用于延迟统计
+        if (bytesRead > 0) {
+            sp->m_lastReadTime.store(monotonicNowNs(), std::memory_order_relaxed);
+        }
+
         // 更新统计计数
         sp->m_totalByteCount.fetch_add(bytesRead);
         
@@ -25,6 +25,7 @@ private:
     OVERLAPPED m_overlappedWrite;                         // 重叠IO结构（写）
     // std::atomic<bool> m_isOpen;                           // 串口是否打开
     std::atomic<U32> m_totalByteCount;                    // 统计总字节数
+    bool m_hwFlowControl;                                 // 是否启用 RTS/CTS 硬件流控
     
     // 回调函数
     std::function<S32(const std::vector<U8>&, S32)> m_onDataReceived;  // 数据接收回调
@@ -87,6 +88,9 @@ public:
         m_onDataSent = callback;
     }
     
+    // 启用 RTS/CTS 硬件流控，需在 connect 之前设置；暂停读取时驱动缓冲区满后拉低 RTS
+    void setHardwareFlowControl(bool enable) { m_hwFlowControl = enable; }
+
     // 状态查询
     U32 getTotalByteCount() const { return m_totalByteCount.load(); }
 };
@@ -0,0 +1,12 @@
+#ifndef __SIMD_CONFIG_H__
+#define __SIMD_CONFIG_H__
+
+// 按编译目标选择向量指令集：AVX2（/arch:AVX2 或 -mavx2）优先，x86-64 默认具备 SSE2，其余平台使用标量实现
+#if defined(__AVX2__)
+#define SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2
+#endif
+
+
+#endif /*__SIMD_CONFIG_H__*/
@@ -234,7 +234,17 @@ DWORD WINAPI TcpSocket::waitForDataThread(LPVOID lpParam) {
     std::vector<U8> buffer(1024);
     
     while (pThis->m_isOpen) {
-        S32 bytesRead = pThis->readBufferInternal(buffer, sizeof(buffer), 100);
+        // 下游没有接收许可时暂停读取，数据留在套接字缓冲区中，由 TCP 窗口反压对端
+        if (pThis->m_canReceive && !pThis->m_canReceive()) {
+            Sleep(1);
+            continue;
+        }
+
+        S32 bytesRead = pThis->readBufferInternal(buffer, static_cast<S32>(buffer.size()), 100);
+        if (bytesRead > 0) {
+            // 记录读取完成时间，用于延迟统计
+            pThis->m_lastReadTime.store(monotonicNowNs(), std::memory_order_relaxed);
+        }
         if (bytesRead > 0 && pThis->m_onDataReceived) {
             pThis->m_onDataReceived(buffer, bytesRead);
         }
@@ -0,0 +1,238 @@
+#include <cmath>
+#include "ThicknessFilter.h"
+
+
+// 滑动平均构造函数
+MovingAverage::MovingAverage(U32 window)
+    : m_window(window == 0 ? 1 : window, 0.0f),
+      m_next(0),
+      m_count(0),
+      m_sum(0.0) {
+}
+
+void MovingAverage::reset() {
+    m_next = 0;
+    m_count = 0;
+    m_sum = 0.0;
+}
+
+float MovingAverage::process(float value) {
+    U32 size = static_cast<U32>(m_window.size());
+    if (m_count == size) {
+        m_sum -= m_window[m_next];
+    } else {
+        ++m_count;
+    }
+    m_window[m_next] = value;
+    m_sum += value;
+    m_next = m_next + 1 == size ? 0 : m_next + 1;
+    return static_cast<float>(m_sum / m_count);
+}
+
+// 滑动中值构造函数
+RunningMedian::RunningMedian(U32 window)
+    : m_window(window == 0 ? 1 : window) {
+    m_low.resize((m_window + 1) / 2 + 1);
+    m_high.resize(m_window / 2 + 1);
+    m_posOf.assign(m_window, 0);
+    reset();
+}
+
+void RunningMedian::reset() {
+    m_lowSize = 0;
+    m_highSize = 0;
+    m_next = 0;
+    m_count = 0;
+}
+
+// 从 pos 处向上为 entry 找位置
+template <bool High>
+void RunningMedian::siftUp(U32 pos, Entry entry) {
+    Entry* data = High ? m_high.data() : m_low.data();
+    U32 flag = High ? HIGH_HEAP_FLAG : 0;
+    while (pos > 0) {
+        U32 parent = (pos - 1) / 2;
+        if (!before<High>(entry.value, data[parent].value)) {
+            break;
+        }
+        data[pos] = data[parent];
+        m_posOf[data[pos].slot] = pos | flag;
+        pos = parent;
+    }
+    data[pos] = entry;
+    m_posOf[entry.slot] = pos | flag;
+}
+
+// 从 pos 处向下为 entry 找位置
+template <bool High>
+void RunningMedian::siftDown(U32 pos, Entry entry) {
+    Entry* data = High ? m_high.data() : m_low.data();
+    U32 size = High ? m_highSize : m_lowSize;
+    U32 flag = High ? HIGH_HEAP_FLAG : 0;
+    while (true) {
+        U32 child = 2 * pos + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && before<High>(data[child + 1].value, data[child].value)) {
+            ++child;
+        }
+        if (!before<High>(data[child].value, entry.value)) {
+            break;
+        }
+        data[pos] = data[child];
+        m_posOf[data[pos].slot] = pos | flag;
+        pos = child;
+    }
+    data[pos] = entry;
+    m_posOf[entry.slot] = pos | flag;
+}
+
+template <bool High>
+void RunningMedian::push(Entry entry) {
+    U32& size = High ? m_highSize : m_lowSize;
+    siftUp<High>(size++, entry);
+}
+
+template <bool High>
+RunningMedian::Entry RunningMedian::pop() {
+    Entry* data = High ? m_high.data() : m_low.data();
+    U32& size = High ? m_highSize : m_lowSize;
+    Entry top = data[0];
+    --size;
+    if (size > 0) {
+        siftDown<High>(0, data[size]);
+    }
+    return top;
+}
+
+float RunningMedian::process(float value) {
+    Entry entry{value, m_next};
+    m_next = m_next + 1 == m_window ? 0 : m_next + 1;
+
+    if (m_count < m_window) {
+        // 填充阶段：放入对应的堆，再平衡两个堆的大小（m_low 比 m_high 多 0 或 1 个）
+        ++m_count;
+        if (m_lowSize == 0 || value <= m_low[0].value) {
+            push<false>(entry);
+            if (m_lowSize > m_highSize + 1) {
+                push<true>(pop<false>());
+            }
+        } else {
+            push<true>(entry);
+            if (m_highSize > m_lowSize) {
+                push<false>(pop<true>());
+            }
+        }
+        return median();
+    }
+
+    // 窗口已满：覆盖最早的数据。新值越过中值分界时放到对侧堆顶并下沉，对侧原堆顶（本堆的边界值）补到空出的位置上浮；
+    // 否则只在原堆中调整
+    U32 where = m_posOf[entry.slot];
+    U32 pos = where & ~HIGH_HEAP_FLAG;
+    if (where & HIGH_HEAP_FLAG) {
+        if (value < m_low[0].value) {
+            Entry top = m_low[0];
+            siftDown<false>(0, entry);
+            siftUp<true>(pos, top);
+        } else if (value < m_high[pos].value) {
+            siftUp<true>(pos, entry);
+        } else {
+            siftDown<true>(pos, entry);
+        }
+    } else {
+        if (m_highSize > 0 && value > m_high[0].value) {
+            Entry top = m_high[0];
+            siftDown<true>(0, entry);
+            siftUp<false>(pos, top);
+        } else if (value > m_low[pos].value) {
+            siftUp<false>(pos, entry);
+        } else {
+            siftDown<false>(pos, entry);
+        }
+    }
+    return median();
+}
+
+float RunningMedian::median() const {
+    if (m_count == 0) {
+        return 0.0f;
+    }
+    if (m_lowSize > m_highSize) {
+        return m_low[0].value;
+    }
+    return 0.5f * (m_low[0].value + m_high[0].value);
+}
+
+// 厚度滤波构造函数
+ThicknessFilter::ThicknessFilter(const ThicknessFilterConfig& config)
+    : m_deviationScale(0.0f),
+      m_consecutiveRejects(0),
+      m_rejectedCount(0) {
+    configure(config);
+}
+
+// 更换配置
+void ThicknessFilter::configure(const ThicknessFilterConfig& config) {
+    m_config = config;
+    m_outlierMedian = RunningMedian(config.outlierWindow);
+    m_median = RunningMedian(config.medianWindow);
+    m_average = MovingAverage(config.averageWindow);
+    m_smoother = ExponentialSmoother(config.emaAlpha);
+    reset();
+}
+
+// 清空状态
+void ThicknessFilter::reset() {
+    m_outlierMedian.reset();
+    m_deviationScale = 0.0f;
+    m_consecutiveRejects = 0;
+    m_median.reset();
+    m_average.reset();
+    m_smoother.reset();
+}
+
+// 处理一个样本
+bool ThicknessFilter::process(float value, float& output) {
+    // 启用中值输出时离群判定与其共用同一个窗口，每个样本只维护一个中值
+    bool sharedMedian = m_config.medianWindow > 0;
+    float filtered = value;
+    if (m_config.outlierLimit > 0.0f) {
+        // 与此前窗口的中值比较，窗口填满半数后开始判定；被拒绝的样本仍进入中值窗口，真实的阶跃变化会逐步被接受
+        RunningMedian& reference = sharedMedian ? m_median : m_outlierMedian;
+        U32 window = sharedMedian ? m_config.medianWindow : m_config.outlierWindow;
+        bool hasReference = reference.count() > 0;
+        bool primed = reference.count() * 2 >= window && m_deviationScale > 0.0f;
+        float deviation = std::fabs(value - reference.median());
+        filtered = reference.process(value);
+        if (primed && deviation > m_config.outlierLimit * m_deviationScale &&
+            m_consecutiveRejects < OUTLIER_MAX_REJECTS) {
+            ++m_consecutiveRejects;
+            ++m_rejectedCount;
+            return false;
+        }
+        m_consecutiveRejects = 0;
+        // 第一个样本之前窗口为空、中值为 0，其偏差只是厚度本身，不计入尺度；尺度由第一个真实偏差起步
+        if (hasReference) {
+            if (m_deviationScale == 0.0f) {
+                m_deviationScale = deviation;
+            } else {
+                m_deviationScale += OUTLIER_SCALE_ALPHA * (deviation - m_deviationScale);
+            }
+        }
+        if (!sharedMedian) {
+            filtered = value;
+        }
+    } else if (sharedMedian) {
+        filtered = m_median.process(value);
+    }
+    if (m_config.averageWindow > 0) {
+        filtered = m_average.process(filtered);
+    }
+    if (m_config.emaAlpha > 0.0f) {
+        filtered = m_smoother.process(filtered);
+    }
+    output = filtered;
+    return true;
+}
@@ -0,0 +1,137 @@
+#ifndef __THICKNESS_FILTER_H__
+#define __THICKNESS_FILTER_H__
+
+#include <cstdint>
+#include <vector>
+
+
+// 使用 C++ using 别名替代 typedef
+using U8 = uint8_t;
+using U32 = uint32_t;
+using U64 = uint64_t;
+
+constexpr float OUTLIER_SCALE_ALPHA = 0.05f;  // 离群判定尺度（与中值偏差的指数平均）的更新系数
+constexpr U32 OUTLIER_MAX_REJECTS = 8;        // 连续拒绝次数上限，超过后接受（视为真实的阶跃变化）
+
+// 滑动平均：环形缓冲区加累加和，每个样本 O(1)
+class MovingAverage {
+private:
+    std::vector<float> m_window; // 窗口数据
+    U32 m_next;                  // 下一个写入位置
+    U32 m_count;                 // 已有数据数
+    double m_sum;                // 窗口内数据和
+
+public:
+    explicit MovingAverage(U32 window = 1);
+
+    void reset();
+    float process(float value);
+};
+
+// 指数平滑：y += alpha * (x - y)
+class ExponentialSmoother {
+private:
+    float m_alpha;
+    float m_value;
+    bool m_primed;
+
+public:
+    explicit ExponentialSmoother(float alpha = 1.0f) : m_alpha(alpha), m_value(0.0f), m_primed(false) {}
+
+    void reset() { m_primed = false; }
+    float process(float value) {
+        if (!m_primed) {
+            m_value = value;
+            m_primed = true;
+        } else {
+            m_value += m_alpha * (value - m_value);
+        }
+        return m_value;
+    }
+};
+
+// 滑动中值：较小一半放在最大堆、较大一半放在最小堆，堆元素带数据值和窗口槽位号，并记录各槽位所在的堆和位置。
+// 窗口满后新数据覆盖最早的槽位，在其所在堆中上浮或下沉，必要时交换两个堆顶，每个样本 O(log n)，不分配内存
+class RunningMedian {
+private:
+    struct Entry {
+        float value;
+        U32 slot;
+    };
+    static constexpr U32 HIGH_HEAP_FLAG = 0x80000000u; // 槽位位置中的堆标志，置位表示在 m_high
+
+    std::vector<Entry> m_low;    // 最大堆（较小一半）
+    std::vector<Entry> m_high;   // 最小堆（较大一半）
+    std::vector<U32> m_posOf;    // 槽位所在的堆（HIGH_HEAP_FLAG）和在堆中的位置
+    U32 m_window;
+    U32 m_lowSize;
+    U32 m_highSize;
+    U32 m_next;                  // 下一个写入（最早）的槽位
+    U32 m_count;                 // 已有数据数
+
+    // 堆顶优先：m_low 中较大者、m_high 中较小者优先
+    template <bool High>
+    static bool before(float a, float b) { return High ? a < b : a > b; }
+    template <bool High>
+    void siftUp(U32 pos, Entry entry);
+    template <bool High>
+    void siftDown(U32 pos, Entry entry);
+    template <bool High>
+    void push(Entry entry);
+    template <bool High>
+    Entry pop();
+
+public:
+    explicit RunningMedian(U32 window = 1);
+
+    void reset();
+
+    // 加入一个数据，返回当前窗口的中值
+    float process(float value);
+
+    // 当前中值，没有数据时返回 0
+    float median() const;
+    U32 count() const { return m_count; }
+};
+
+// 厚度滤波配置，各级为 0 时不启用
+struct ThicknessFilterConfig {
+    U32 medianWindow = 0;      // 滑动中值窗口
+    U32 averageWindow = 0;     // 滑动平均窗口
+    float emaAlpha = 0.0f;     // 指数平滑系数（0, 1]
+    float outlierLimit = 0.0f; // 离群拒绝：与滑动中值之差超过 outlierLimit × 偏差尺度时丢弃
+    U32 outlierWindow = 15;    // 离群判定使用的中值窗口，仅在未启用中值输出时使用（否则共用 medianWindow）
+};
+
+// 厚度流式滤波：离群拒绝 → 滑动中值 → 滑动平均 → 指数平滑。
+// 每台设备一个实例，在厚度数据到达时调用，非线程安全；每个样本几十纳秒，不分配内存
+class ThicknessFilter {
+private:
+    ThicknessFilterConfig m_config;
+    RunningMedian m_outlierMedian; // 离群判定用中值（未启用中值输出时）
+    float m_deviationScale;        // 与中值偏差绝对值的指数平均
+    U32 m_consecutiveRejects;      // 连续拒绝次数
+    RunningMedian m_median;
+    MovingAverage m_average;
+    ExponentialSmoother m_smoother;
+    U64 m_rejectedCount;           // 累计拒绝的样本数
+
+public:
+    explicit ThicknessFilter(const ThicknessFilterConfig& config = ThicknessFilterConfig());
+
+    // 更换配置并清空状态
+    void configure(const ThicknessFilterConfig& config);
+    const ThicknessFilterConfig& config() const { return m_config; }
+
+    // 清空状态
+    void reset();
+
+    // 处理一个样本，被判为离群值时返回 false；否则 output 为滤波结果
+    bool process(float value, float& output);
+
+    // 累计拒绝的样本数
+    U64 getRejectedCount() const { return m_rejectedCount; }
+};
+
+
+#endif /*__THICKNESS_FILTER_H__*/
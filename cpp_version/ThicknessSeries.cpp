@@ -0,0 +1,124 @@
+#include <cmath>
+#include "ThicknessSeries.h"
+
+
+// 构造函数，容量向上取 2 的幂
+ThicknessSeries::ThicknessSeries(U32 capacity) {
+    U64 size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    m_samples.resize(size);
+    m_mask = size - 1;
+    reset();
+}
+
+void ThicknessSeries::reset() {
+    m_end = 0;
+    m_tsStep = 0.0;
+    m_stats = SeriesStats();
+}
+
+// 加入一个样本
+S32 ThicknessSeries::append(U64 hostNs, U8 seq, U16 deviceTs, float thickness) {
+    S32 status = SERIES_SAMPLE_OK;
+    U64 lost = 0;
+    if (m_end > 0) {
+        const ThicknessSample& last = at(m_end - 1);
+        U32 delta = (seq - last.seq) & (SERIES_SEQ_MODULO - 1);
+        if (delta == 0) {
+            ++m_stats.duplicates;
+            return SERIES_SAMPLE_DUPLICATE;
+        }
+        U16 tsDelta = static_cast<U16>(deviceTs - last.deviceTs);
+        // 序号差超过半圈时既可能是落后的序号，也可能是前方丢失了半圈以上：设备时间戳倒退才是迟到的包，
+        // 时间戳相同（同一时间戳单位内的包）时无法区分，按序号视为迟到
+        if (delta > SERIES_SEQ_MODULO - SERIES_LATE_WINDOW && static_cast<S16>(tsDelta) <= 0) {
+            // 落后的序号：此前已按丢包计入
+            ++m_stats.late;
+            if (m_stats.lost > 0) {
+                --m_stats.lost;
+            }
+            return SERIES_SAMPLE_LATE;
+        }
+        if (delta == 1) {
+            m_tsStep = m_tsStep == 0.0 ? tsDelta : m_tsStep + SERIES_TS_STEP_ALPHA * (tsDelta - m_tsStep);
+        } else {
+            lost = delta - 1;
+            // 时间戳跨度超出序号差一圈以上时，按时间戳补上整圈的丢包
+            if (m_tsStep > 0.0) {
+                double steps = tsDelta / m_tsStep;
+                if (steps > delta + SERIES_SEQ_MODULO / 2) {
+                    lost += static_cast<U64>(std::floor((steps - delta) / SERIES_SEQ_MODULO + 0.5)) * SERIES_SEQ_MODULO;
+                }
+            }
+            m_stats.lost += lost;
+            ++m_stats.gapEvents;
+            status = SERIES_SAMPLE_GAP;
+        }
+    }
+    ThicknessSample& sample = m_samples[m_end & m_mask];
+    sample.hostNs = hostNs;
+    sample.lostTotal = (m_end > 0 ? at(m_end - 1).lostTotal : 0) + lost;
+    sample.thickness = thickness;
+    sample.gap = static_cast<U32>(lost);
+    sample.deviceTs = deviceTs;
+    sample.seq = seq;
+    ++m_end;
+    ++m_stats.received;
+    return status;
+}
+
+// 二分查找窗口边界
+U64 ThicknessSeries::lowerBound(U64 timeNs) const {
+    U64 lo = begin();
+    U64 hi = m_end;
+    while (lo < hi) {
+        U64 mid = lo + (hi - lo) / 2;
+        if (at(mid).hostNs < timeNs) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// 取出时间窗口内的样本
+U32 ThicknessSeries::query(U64 fromNs, U64 toNs, std::vector<ThicknessSample>& out) const {
+    if (toNs <= fromNs) {
+        return 0;
+    }
+    U64 first = lowerBound(fromNs);
+    U64 last = lowerBound(toNs);
+    for (U64 i = first; i < last; ++i) {
+        out.push_back(at(i));
+    }
+    return static_cast<U32>(last - first);
+}
+
+// 时间窗口统计
+SeriesWindow ThicknessSeries::window(U64 fromNs, U64 toNs) const {
+    SeriesWindow result{0, 0, 0.0};
+    if (toNs <= fromNs) {
+        return result;
+    }
+    U64 first = lowerBound(fromNs);
+    U64 last = lowerBound(toNs);
+    if (first == last) {
+        return result;
+    }
+    result.count = static_cast<U32>(last - first);
+    U64 lostBefore = first > begin() ? at(first - 1).lostTotal : at(first).lostTotal - at(first).gap;
+    result.lost = at(last - 1).lostTotal - lostBefore;
+    result.lossRate = static_cast<double>(result.lost) / (result.count + result.lost);
+    return result;
+}
+
+// 累计统计
+SeriesStats ThicknessSeries::stats() const {
+    SeriesStats result = m_stats;
+    U64 total = result.received + result.lost;
+    result.lossRate = total > 0 ? static_cast<double>(result.lost) / total : 0.0;
+    return result;
+}
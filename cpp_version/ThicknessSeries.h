@@ -0,0 +1,94 @@
+#ifndef __THICKNESS_SERIES_H__
+#define __THICKNESS_SERIES_H__
+
+#include <cstdint>
+#include <vector>
+
+
+// 使用 C++ using 别名替代 typedef
+using U8 = uint8_t;
+using U16 = uint16_t;
+using U32 = uint32_t;
+using U64 = uint64_t;
+using S16 = int16_t;
+using S32 = int32_t;
+
+constexpr U32 SERIES_SEQ_MODULO = 256;      // 厚度数据包序号 0x00~0xFF 循环
+constexpr U32 SERIES_LATE_WINDOW = 128;     // 序号落后不超过此值时可能是迟到的包，由设备时间戳是否倒退区分迟到与前方的丢包
+constexpr double SERIES_TS_STEP_ALPHA = 0.1; // 每包设备时间戳间隔估计的更新系数
+
+// 样本到达时的判定
+constexpr S32 SERIES_SAMPLE_OK = 0;         // 序号连续
+constexpr S32 SERIES_SAMPLE_GAP = 1;        // 之前有丢包，已记入并保存该样本
+constexpr S32 SERIES_SAMPLE_DUPLICATE = -1; // 与上一包序号相同，丢弃
+constexpr S32 SERIES_SAMPLE_LATE = -2;      // 早于上一包的迟到包，不保存，从丢包数中扣除
+
+// 厚度时间序列中的一个样本
+struct ThicknessSample {
+    U64 hostNs;       // 主机收到的时间（单调时钟 ns）
+    U64 lostTotal;    // 截至该样本（含其之前的间隙）累计丢失的包数
+    float thickness;  // 厚度（mm）
+    U32 gap;          // 该样本之前丢失的包数
+    U16 deviceTs;     // 设备时间戳
+    U8 seq;           // 包序号
+};
+
+// 时间窗口统计
+struct SeriesWindow {
+    U32 count;       // 窗口内样本数
+    U64 lost;        // 窗口内丢失的包数
+    double lossRate; // 丢包率 lost / (count + lost)
+};
+
+// 累计统计
+struct SeriesStats {
+    U64 received;    // 保存的样本数
+    U64 lost;        // 丢失的包数
+    U64 duplicates;  // 重复包数
+    U64 late;        // 迟到包数
+    U64 gapEvents;   // 出现间隙的次数
+    double lossRate; // 丢包率 lost / (received + lost)
+};
+
+// 厚度时间序列：按到达顺序保存样本的环形缓冲区（容量为 2 的幂，满后覆盖最早的样本），
+// 到达时按包序号检测丢包、重复和迟到的包，序号差超过半圈时按设备时间戳是否倒退区分迟到的包与前方的丢包；
+// 序号循环一圈以上的丢包由设备时间戳按每包间隔估算。
+// 样本带累计丢包数，按主机时间二分查找窗口边界，窗口统计为 O(log n)。非线程安全，由调用者加锁
+class ThicknessSeries {
+private:
+    std::vector<ThicknessSample> m_samples; // 环形缓冲区
+    U64 m_mask;                             // 容量 - 1
+    U64 m_end;                              // 已保存的样本总数，最新样本的绝对序号为 m_end - 1
+    double m_tsStep;                        // 每包设备时间戳间隔估计，0 表示尚未估计
+    SeriesStats m_stats;
+
+    const ThicknessSample& at(U64 index) const { return m_samples[index & m_mask]; }
+
+    // 第一个 hostNs >= timeNs 的样本序号
+    U64 lowerBound(U64 timeNs) const;
+
+public:
+    explicit ThicknessSeries(U32 capacity);
+
+    void reset();
+
+    // 加入一个样本，返回 SERIES_SAMPLE_*
+    S32 append(U64 hostNs, U8 seq, U16 deviceTs, float thickness);
+
+    // 仍保存的样本绝对序号范围 [begin, end)
+    U64 begin() const { return m_end > m_samples.size() ? m_end - m_samples.size() : 0; }
+    U64 end() const { return m_end; }
+    const ThicknessSample& sample(U64 index) const { return at(index); }
+
+    // 主机时间 [fromNs, toNs) 内的样本追加到 out，返回个数
+    U32 query(U64 fromNs, U64 toNs, std::vector<ThicknessSample>& out) const;
+
+    // 主机时间 [fromNs, toNs) 内的样本数和丢包数（只计窗口内样本之前的间隙，不因之后的迟到包修正）
+    SeriesWindow window(U64 fromNs, U64 toNs) const;
+
+    // 累计统计
+    SeriesStats stats() const;
+};
+
+
+#endif /*__THICKNESS_SERIES_H__*/
@@ -0,0 +1,174 @@
+#include <iterator>
+#include <algorithm>
+#include "TimerWheel.h"
+
+
+// 构造函数
+TimerWheel::TimerWheel(U64 nowNs)
+    : m_originNs(nowNs),
+      m_currentTick(0) {
+}
+
+// 按到期刻度放入对应层的槽位：距离当前刻度越远放在越高的层
+void TimerWheel::place(U32 key, U64 tick) {
+    constexpr U64 maxDelta = (1ull << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+    if (tick - m_currentTick > maxDelta) {
+        tick = m_currentTick + maxDelta;
+    }
+    U64 delta = tick - m_currentTick;
+    U32 level = 0;
+    while (level + 1 < TIMER_WHEEL_LEVELS && delta >= (1ull << (TIMER_WHEEL_BITS * (level + 1)))) {
+        ++level;
+    }
+    U32 slot = static_cast<U32>(tick >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+    Slot& target = m_levels[level][slot];
+    target.push_back({key, tick});
+    m_locations[key] = {level, slot, std::prev(target.end())};
+}
+
+// 把某层当前槽位的定时器重新放入低层，恰好在当前刻度到期的放入第 0 层当前槽位，随后立即触发
+void TimerWheel::cascade(U32 level) {
+    U32 slot = static_cast<U32>(m_currentTick >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+    Slot entries;
+    entries.swap(m_levels[level][slot]);
+    for (const auto& entry : entries) {
+        place(entry.key, entry.tick);
+    }
+}
+
+// 整体重新定位到 nowTick
+void TimerWheel::rebase(U64 nowTick, std::vector<U32>& expired) {
+    std::vector<TimerEntry> entries;
+    entries.reserve(m_locations.size());
+    for (auto& level : m_levels) {
+        for (auto& slot : level) {
+            entries.insert(entries.end(), slot.begin(), slot.end());
+            slot.clear();
+        }
+    }
+    m_locations.clear();
+    m_currentTick = nowTick;
+    std::sort(entries.begin(), entries.end(), [](const TimerEntry& a, const TimerEntry& b) {
+        return a.tick < b.tick;
+    });
+    for (const auto& entry : entries) {
+        if (entry.tick <= nowTick) {
+            expired.push_back(entry.key);
+        } else {
+            place(entry.key, entry.tick);
+        }
+    }
+}
+
+// 登记定时器
+void TimerWheel::schedule(U32 key, U64 deadlineNs, U64 nowNs) {
+    cancel(key);
+    U64 nowTick = tickOf(nowNs);
+    if (nowTick > m_currentTick + TIMER_WHEEL_SLOTS) {
+        if (m_locations.empty()) {
+            m_currentTick = nowTick;
+        } else {
+            rebase(nowTick, m_due);
+        }
+    }
+    U64 tick = deadlineNs > m_originNs
+        ? (deadlineNs - m_originNs + TIMER_WHEEL_TICK_NS - 1) / TIMER_WHEEL_TICK_NS
+        : 0;
+    if (tick <= m_currentTick) {
+        tick = m_currentTick + 1; // 已过期的定时器在下一刻度触发
+    }
+    place(key, tick);
+}
+
+// 取消定时器
+bool TimerWheel::cancel(U32 key) {
+    auto it = m_locations.find(key);
+    if (it == m_locations.end()) {
+        auto due = std::find(m_due.begin(), m_due.end(), key);
+        if (due == m_due.end()) {
+            return false;
+        }
+        m_due.erase(due);
+        return true;
+    }
+    m_levels[it->second.level][it->second.slot].erase(it->second.entry);
+    m_locations.erase(it);
+    return true;
+}
+
+// 推进到 nowNs
+void TimerWheel::advance(U64 nowNs, std::vector<U32>& expired) {
+    // 登记时重新定位已到期的定时器
+    expired.insert(expired.end(), m_due.begin(), m_due.end());
+    m_due.clear();
+    U64 nowTick = tickOf(nowNs);
+    if (m_locations.empty()) {
+        // 没有定时器，直接跳到当前刻度
+        if (nowTick > m_currentTick) {
+            m_currentTick = nowTick;
+        }
+        return;
+    }
+    if (nowTick > m_currentTick + TIMER_WHEEL_SLOTS) {
+        // 落后超过一圈（服务线程长时间睡眠或停止），整体重新定位，不逐格推进
+        rebase(nowTick, expired);
+        return;
+    }
+    while (m_currentTick < nowTick) {
+        ++m_currentTick;
+        // 低层转满一圈时，从高到低依次下沉高层当前槽位
+        U32 top = 0;
+        while (top + 1 < TIMER_WHEEL_LEVELS &&
+               (m_currentTick & ((1ull << (TIMER_WHEEL_BITS * (top + 1))) - 1)) == 0) {
+            ++top;
+        }
+        for (U32 level = top; level > 0; --level) {
+            cascade(level);
+        }
+        // 触发第 0 层当前槽位
+        Slot& slot = m_levels[0][m_currentTick & (TIMER_WHEEL_SLOTS - 1)];
+        for (const auto& entry : slot) {
+            expired.push_back(entry.key);
+            m_locations.erase(entry.key);
+        }
+        slot.clear();
+        if (m_locations.empty()) {
+            m_currentTick = nowTick;
+            break;
+        }
+    }
+}
+
+// 最早的到期时间
+U64 TimerWheel::nextDeadline() const {
+    if (!m_due.empty()) {
+        return m_originNs + m_currentTick * TIMER_WHEEL_TICK_NS;
+    }
+    if (m_locations.empty()) {
+        return 0;
+    }
+    // 高层定时器都不早于第 0 层下一次转满一圈的刻度，第 0 层中不晚于该刻度的定时器即为最早
+    U64 boundary = (m_currentTick | (TIMER_WHEEL_SLOTS - 1)) + 1;
+    U64 earliest = UINT64_MAX;
+    for (U32 i = 1; i <= TIMER_WHEEL_SLOTS; ++i) {
+        U64 tick = m_currentTick + i;
+        if (!m_levels[0][tick & (TIMER_WHEEL_SLOTS - 1)].empty()) {
+            if (tick <= boundary) {
+                return m_originNs + tick * TIMER_WHEEL_TICK_NS;
+            }
+            earliest = tick;
+            break;
+        }
+    }
+    // 否则在高层中取最早的刻度（只在近期没有定时器时遍历）
+    for (U32 level = 1; level < TIMER_WHEEL_LEVELS; ++level) {
+        for (const auto& slot : m_levels[level]) {
+            for (const auto& entry : slot) {
+                if (entry.tick < earliest) {
+                    earliest = entry.tick;
+                }
+            }
+        }
+    }
+    return m_originNs + earliest * TIMER_WHEEL_TICK_NS;
+}
@@ -0,0 +1,79 @@
+#ifndef __TIMER_WHEEL_H__
+#define __TIMER_WHEEL_H__
+
+#include <cstdint>
+#include <vector>
+#include <list>
+#include <array>
+#include <unordered_map>
+
+
+// 使用 C++ using 别名替代 typedef
+using U32 = uint32_t;
+using U64 = uint64_t;
+
+// 分层时间轮参数：4 层，每层 64 个槽位，1ms 一格，最长约 4.6 小时，更远的定时器按最长时间处理
+constexpr U32 TIMER_WHEEL_BITS = 6;
+constexpr U32 TIMER_WHEEL_SLOTS = 1u << TIMER_WHEEL_BITS;
+constexpr U32 TIMER_WHEEL_LEVELS = 4;
+constexpr U64 TIMER_WHEEL_TICK_NS = 1000000;  // 时间轮刻度（1ms）
+
+// 分层时间轮：按键登记到期时间（单调时钟 ns），登记、取消均为 O(1)，推进时只处理到期的槽位，
+// 高层槽位在低层转满一圈时下沉到低层；落后超过一圈时整体重新定位，不逐格推进。非线程安全，由调用者加锁
+class TimerWheel {
+private:
+    // 定时器
+    struct TimerEntry {
+        U32 key;   // 定时器键
+        U64 tick;  // 到期刻度
+    };
+    using Slot = std::list<TimerEntry>;
+
+    // 定时器位置，用于取消
+    struct TimerLocation {
+        U32 level;
+        U32 slot;
+        Slot::iterator entry;
+    };
+
+    std::array<std::array<Slot, TIMER_WHEEL_SLOTS>, TIMER_WHEEL_LEVELS> m_levels; // 各层槽位
+    std::unordered_map<U32, TimerLocation> m_locations;                             // 键到位置的索引
+    std::vector<U32> m_due;                                                         // 登记时重新定位已到期、等待 advance 取出的定时器键
+    U64 m_originNs;     // 刻度 0 对应的时间
+    U64 m_currentTick;  // 已处理到的刻度
+
+    // 时间对应的刻度（向下取整）
+    U64 tickOf(U64 nowNs) const { return nowNs > m_originNs ? (nowNs - m_originNs) / TIMER_WHEEL_TICK_NS : 0; }
+
+    // 按到期刻度放入对应层的槽位
+    void place(U32 key, U64 tick);
+
+    // 把某层当前槽位的定时器重新放入低层
+    void cascade(U32 level);
+
+    // 当前刻度落后较多时直接跳到 nowTick：已到期的定时器键按到期顺序追加到 expired，其余按新的当前刻度重新放置，
+    // 开销与定时器数量成正比，与落后的刻度数无关
+    void rebase(U64 nowTick, std::vector<U32>& expired);
+
+public:
+    explicit TimerWheel(U64 nowNs);
+
+    // 登记定时器，同一键已存在时改为新的到期时间；nowNs 为当前时间，
+    // 长时间没有推进（如服务线程停止期间）时先跳到当前刻度，避免到期时间按过时的刻度截断
+    void schedule(U32 key, U64 deadlineNs, U64 nowNs);
+
+    // 取消定时器，不存在时返回 false
+    bool cancel(U32 key);
+
+    // 推进到 nowNs，到期的定时器键追加到 expired
+    void advance(U64 nowNs, std::vector<U32>& expired);
+
+    // 最早的到期时间（ns），没有定时器时返回 0
+    U64 nextDeadline() const;
+
+    // 定时器数量
+    U32 size() const { return static_cast<U32>(m_locations.size() + m_due.size()); }
+};
+
+
+#endif /*__TIMER_WHEEL_H__*/
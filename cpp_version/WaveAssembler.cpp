@@ -0,0 +1,103 @@
+#include <iostream>
+#include "WaveAssembler.h"
+
+
+// 构造函数
+WaveAssembler::WaveAssembler(WavePool& pool)
+    : m_pool(pool),
+      m_receivedMask(0),
+      m_expectedMask(0),
+      m_rerequests(0),
+      m_active(false) {
+}
+
+// 处理信息帧
+S32 WaveAssembler::onInfo(const std::vector<U8>& frame, U32 len) {
+    if (len < WAVE_INFO_FRAME_LEN || frame.size() < WAVE_INFO_FRAME_LEN) {
+        return WAVE_RESULT_INVALID;
+    }
+    U32 totalFrames = frame[2];
+    U32 totalLen = readU16(frame, 3);
+    if (totalFrames == 0 || totalFrames > WAVE_MAX_FRAMES ||
+        totalLen > WAVE_POINT_NUM * sizeof(S16) || totalLen > totalFrames * WAVE_DATA_FRAME_BYTES) {
+        std::cerr << "Invalid wave info: " << totalFrames << " frames, " << totalLen << " bytes" << std::endl;
+        m_active = false;
+        return WAVE_RESULT_INVALID;
+    }
+    if (!m_wave) {
+        m_wave = m_pool.acquire();
+        if (!m_wave) {
+            std::cerr << "No free wave buffer, wave dropped" << std::endl;
+            m_active = false;
+            return WAVE_RESULT_INVALID;
+        }
+    }
+    WaveBuffer* wave = m_wave.mutableWave();
+    WaveHeader header;
+    header.totalFrames = totalFrames;
+    header.totalLen = totalLen & ~1u;
+    header.thick = float(readU16(frame, 6)) / 1000.0f;
+    header.wave_pos_first = float(readU16(frame, 8)) / 100.0f;
+    header.wave_pos_second = float(readU16(frame, 10)) / 100.0f;
+    header.curGain = float(readU16(frame, 12)) / 10.0f;
+    header.excitation_freq = float(readU16(frame, 14)) / 100.0f;
+    header.measureControlMode = static_cast<INT16>(readU16(frame, 16));
+    wave->setHeader(header);
+    wave->setSize(header.totalLen / 2);
+    m_expectedMask = totalFrames == 32 ? 0xFFFFFFFFu : (1u << totalFrames) - 1;
+    m_receivedMask = 0;
+    m_rerequests = 0;
+    m_active = true;
+    return WAVE_RESULT_PENDING;
+}
+
+// 处理数据帧
+S32 WaveAssembler::onData(const std::vector<U8>& frame, U32 len) {
+    if (!m_active || len < WAVE_DATA_HEADER_LEN || frame.size() < len) {
+        return WAVE_RESULT_INVALID;
+    }
+    U32 frameNo = frame[1];
+    U32 offset = readU16(frame, 2);
+    U32 bytes = (len - WAVE_DATA_HEADER_LEN) & ~1u;
+    const WaveHeader& header = m_wave->header();
+    if (frameNo == 0 || frameNo > header.totalFrames || (offset & 1) != 0 ||
+        bytes > WAVE_DATA_FRAME_BYTES || offset + bytes > header.totalLen) {
+        return WAVE_RESULT_INVALID;
+    }
+    // 采样点为大端 S16，直接解码到偏移位置
+    m_wave.mutableWave()->decode(offset / 2, frame.data() + WAVE_DATA_HEADER_LEN, bytes / 2);
+    m_receivedMask |= 1u << (frameNo - 1);
+    return complete() ? WAVE_RESULT_COMPLETE : WAVE_RESULT_PENDING;
+}
+
+// 处理设备的确认帧
+S32 WaveAssembler::onAck(const std::vector<U8>& frame, U32 len) {
+    if (!m_active || len < WAVE_ACK_FRAME_LEN) {
+        return WAVE_RESULT_INVALID;
+    }
+    if (complete()) {
+        return WAVE_RESULT_COMPLETE;
+    }
+    if (m_rerequests >= WAVE_MAX_REREQUESTS) {
+        std::cerr << "Wave transfer aborted, missing frames 0x" << std::hex << missingMask()
+                  << std::dec << " (device sent " << int(frame[2]) << " frames, "
+                  << readU16(frame, 3) << " bytes)" << std::endl;
+        m_active = false;
+        return WAVE_RESULT_ABORTED;
+    }
+    ++m_rerequests;
+    return WAVE_RESULT_PENDING;
+}
+
+// 取出已完成的波形
+WaveHandle WaveAssembler::take() {
+    m_active = false;
+    return std::move(m_wave);
+}
+
+// 确认反馈命令
+std::vector<U8> WaveAssembler::ackCommand() const {
+    return {0x22, 0xAA,
+            static_cast<U8>(m_receivedMask >> 24), static_cast<U8>(m_receivedMask >> 16),
+            static_cast<U8>(m_receivedMask >> 8), static_cast<U8>(m_receivedMask)};
+}
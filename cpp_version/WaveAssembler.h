@@ -0,0 +1,76 @@
+#ifndef __WAVE_ASSEMBLER_H__
+#define __WAVE_ASSEMBLER_H__
+
+#include <cstdint>
+#include <vector>
+#include "WavePool.h"
+
+
+// 使用 C++ using 别名替代 typedef
+using U8 = uint8_t;
+using U16 = uint16_t;
+using U32 = uint32_t;
+using S16 = int16_t;
+using S32 = int32_t;
+
+// 波形帧（0x22）的帧序号
+constexpr U8 WAVE_INFO_FRAME_NO = 0x00;        // 信息帧
+constexpr U8 WAVE_ACK_FRAME_NO = 0xFF;         // 确认帧（设备发送完毕）
+constexpr U32 WAVE_INFO_FRAME_LEN = 18;        // 信息帧长度：命令字、帧序号、总帧数、总长度、校验码、6 个描述值
+constexpr U32 WAVE_ACK_FRAME_LEN = 6;          // 确认帧长度：命令字、0xFF、已发帧数、已发长度、校验码
+constexpr U32 WAVE_DATA_HEADER_LEN = 4;        // 数据帧头部：命令字、帧序号、数据偏移
+constexpr U32 WAVE_DATA_FRAME_BYTES = 96;      // 数据帧最多携带的波形字节数（48 个 S16）
+constexpr U32 WAVE_MAX_FRAMES = 32;            // 数据帧数上限，接收位图与确认反馈的 4 字节一一对应
+constexpr U32 WAVE_MAX_REREQUESTS = 3;         // 一次传输中补发请求的最大次数
+
+// 波形处理结果
+constexpr S32 WAVE_RESULT_PENDING = 0;         // 传输进行中
+constexpr S32 WAVE_RESULT_COMPLETE = 1;        // 全部数据帧已收到
+constexpr S32 WAVE_RESULT_INVALID = -1;        // 帧内容与当前传输不符，已丢弃
+constexpr S32 WAVE_RESULT_ABORTED = -2;        // 补发次数用尽，传输放弃
+
+// 波形重组：信息帧开始一次传输，数据帧按数据偏移（字节）直接解码到从发布池取得的后台缓冲区，
+// 位图记录已收到的数据帧（第 n 帧对应第 n-1 位）。重复帧直接覆盖，乱序帧按偏移写入。
+// 由本设备的帧调度器单线程调用，非线程安全
+class WaveAssembler {
+private:
+    WavePool& m_pool;           // 波形发布池
+    WaveHandle m_wave;          // 当前传输的后台缓冲区（填充方独占，放弃的传输复用该缓冲区）
+    U32 m_receivedMask;         // 已收到的数据帧位图
+    U32 m_expectedMask;         // 全部数据帧位图
+    U32 m_rerequests;           // 已发出的补发请求数
+    bool m_active;              // 是否有进行中的传输
+
+    // 大端读取
+    static U16 readU16(const std::vector<U8>& frame, U32 pos) {
+        return static_cast<U16>(frame[pos] << 8 | frame[pos + 1]);
+    }
+
+public:
+    explicit WaveAssembler(WavePool& pool);
+
+    // 处理信息帧，开始新的传输（未完成的旧传输被放弃）
+    S32 onInfo(const std::vector<U8>& frame, U32 len);
+
+    // 处理数据帧，全部数据帧到齐时返回 WAVE_RESULT_COMPLETE
+    S32 onData(const std::vector<U8>& frame, U32 len);
+
+    // 处理设备的确认帧：数据帧齐全时返回 WAVE_RESULT_COMPLETE，
+    // 缺帧时计一次补发并返回 WAVE_RESULT_PENDING，补发次数用尽时放弃传输
+    S32 onAck(const std::vector<U8>& frame, U32 len);
+
+    // 取出已完成的波形用于发布，并结束当前传输
+    WaveHandle take();
+
+    // 确认反馈命令（0x22 0xAA + 4 字节接收位图，大端），设备据此补发缺失的数据帧
+    std::vector<U8> ackCommand() const;
+
+    bool active() const { return m_active; }
+    bool complete() const { return m_active && m_receivedMask == m_expectedMask; }
+    U32 receivedMask() const { return m_receivedMask; }
+    U32 missingMask() const { return m_expectedMask & ~m_receivedMask; }
+    const WaveHeader& header() const { return m_wave->header(); }
+};
+
+
+#endif /*__WAVE_ASSEMBLER_H__*/
@@ -0,0 +1,123 @@
+#include "WaveBuffer.h"
+#include "SimdConfig.h"
+#if defined(SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(SIMD_SSE2)
+#include <emmintrin.h>
+#endif
+
+
+// 大端 S16 采样点解码
+void decodeBigEndianS16(const U8* src, S16* dst, U32 count) {
+    U32 i = 0;
+#if defined(SIMD_AVX2)
+    // 每次 16 个采样点：按字节重排交换每个 16 位字的高低字节
+    const __m256i swap = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                          1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    for (; i + 16 <= count; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(v, swap));
+    }
+#endif
+#if defined(SIMD_AVX2) || defined(SIMD_SSE2)
+    // 每次 8 个采样点：16 位移位后合并
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = static_cast<S16>(src[2 * i] << 8 | src[2 * i + 1]);
+    }
+}
+
+// S16 转 float
+void convertSamples(const S16* src, float* dst, U32 count) {
+    U32 i = 0;
+#if defined(SIMD_AVX2)
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v)));
+    }
+#elif defined(SIMD_SSE2)
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        // 与自身交错后算术右移 16 位完成符号扩展
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(lo));
+        _mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(hi));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = static_cast<float>(src[i]);
+    }
+}
+
+// S16 转 double
+void convertSamples(const S16* src, double* dst, U32 count) {
+    for (U32 i = 0; i < count; ++i) {
+        dst[i] = static_cast<double>(src[i]);
+    }
+}
+
+// 构造函数
+WaveBuffer::WaveBuffer()
+    : m_samples(WAVE_POINT_NUM, 0),
+      m_size(0),
+      m_timeStart(0.0),
+      m_timeStep(0.0),
+      m_header(),
+      m_pyramid(0, WAVE_POINT_NUM) {
+}
+
+// 解码数据帧内容
+void WaveBuffer::decode(U32 offset, const U8* src, U32 count) {
+    if (offset >= WAVE_POINT_NUM) {
+        return;
+    }
+    if (count > WAVE_POINT_NUM - offset) {
+        count = WAVE_POINT_NUM - offset;
+    }
+    decodeBigEndianS16(src, m_samples.data() + offset, count);
+}
+
+// 设置有效采样点数
+void WaveBuffer::setSize(U32 size) {
+    m_size = size < WAVE_POINT_NUM ? size : WAVE_POINT_NUM;
+}
+
+// 重建金字塔
+void WaveBuffer::buildPyramid() {
+    m_pyramid.clear();
+    m_pyramid.append(m_samples.data(), m_size);
+}
+
+// 按时间区间取包络
+U32 WaveBuffer::envelope(double t0, double t1, U32 pixels, std::vector<MinMaxPair<S16>>& out) const {
+    if (m_timeStep <= 0.0 || t1 <= t0) {
+        out.clear();
+        return 0;
+    }
+    double first = (t0 - m_timeStart) / m_timeStep;
+    double last = (t1 - m_timeStart) / m_timeStep;
+    U64 a = first > 0.0 ? static_cast<U64>(first) : 0;
+    U64 b = last > 0.0 ? static_cast<U64>(last + 0.999999) : 0;
+    return m_pyramid.envelope(a, b, pixels, out);
+}
+
+// 转换为点列形式
+void WaveBuffer::toDisplayData(DISPLAY_WAVE_DATA& wave) const {
+    wave.thick = m_header.thick;
+    wave.wave_pos_first = m_header.wave_pos_first;
+    wave.wave_pos_second = m_header.wave_pos_second;
+    wave.curGain = m_header.curGain;
+    wave.excitation_freq = m_header.excitation_freq;
+    wave.measureControlMode = m_header.measureControlMode;
+    wave.pt_vec.resize(m_size);
+    for (U32 i = 0; i < m_size; ++i) {
+        wave.pt_vec[i].time = m_timeStart + m_timeStep * i;
+        wave.pt_vec[i].amp = m_samples[i];
+    }
+}
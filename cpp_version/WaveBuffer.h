@@ -0,0 +1,105 @@
+#ifndef __WAVE_BUFFER_H__
+#define __WAVE_BUFFER_H__
+
+#include <cstdint>
+#include <vector>
+#include "paramDefine.h"
+#include "MinMaxPyramid.h"
+
+
+// 使用 C++ using 别名替代 typedef
+using U8 = uint8_t;
+using U32 = uint32_t;
+using S16 = int16_t;
+
+// 信息帧中的波形描述
+struct WaveHeader {
+    U32 totalFrames;          // 数据帧数
+    U32 totalLen;             // 波形总字节数
+    float thick;              // 设备测得的厚度（mm）
+    float wave_pos_first;     // 一次回波位置（us）
+    float wave_pos_second;    // 二次回波位置（us）
+    float curGain;            // 当前增益（dB）
+    float excitation_freq;    // 激励频率
+    INT16 measureControlMode; // 测量控制模式
+};
+
+// 大端 S16 采样点解码（字节交换），src 为 count*2 字节
+void decodeBigEndianS16(const U8* src, S16* dst, U32 count);
+
+// S16 采样点转换为 float / double
+void convertSamples(const S16* src, float* dst, U32 count);
+void convertSamples(const S16* src, double* dst, U32 count);
+
+// 按需转换的只读视图：不占额外存储，下标访问时才计算
+template <typename T>
+class WaveAxisView {
+private:
+    const S16* m_samples; // 采样点，为空时表示时间轴
+    T m_start;            // 时间轴起点
+    T m_step;             // 时间轴步长
+    U32 m_size;
+
+public:
+    WaveAxisView(const S16* samples, T start, T step, U32 size)
+        : m_samples(samples), m_start(start), m_step(step), m_size(size) {}
+
+    T operator[](U32 i) const {
+        return m_samples != nullptr ? static_cast<T>(m_samples[i]) : m_start + m_step * static_cast<T>(i);
+    }
+    U32 size() const { return m_size; }
+};
+
+// 结构数组形式的波形：原始 S16 采样点加仿射时间轴 time(i) = timeStart + timeStep * i，
+// 每点 2 字节（DISPLAY_WAVE_DATA::pt_vec 每点 16 字节），需要浮点数据时再按需转换
+class WaveBuffer {
+private:
+    std::vector<S16> m_samples; // 采样点（容量固定为 WAVE_POINT_NUM）
+    U32 m_size;                 // 有效采样点数
+    double m_timeStart;         // 时间轴起点（us）
+    double m_timeStep;          // 时间轴步长（us）
+    WaveHeader m_header;        // 信息帧描述
+    MinMaxPyramid<S16> m_pyramid; // 显示用最小/最大值金字塔
+
+public:
+    WaveBuffer();
+
+    // 解码大端数据帧内容到偏移 offset（采样点）处，超出容量的部分被丢弃
+    void decode(U32 offset, const U8* src, U32 count);
+
+    // 设置有效采样点数（不超过 WAVE_POINT_NUM）
+    void setSize(U32 size);
+    void setTimeAxis(double start, double step) { m_timeStart = start; m_timeStep = step; }
+    void setHeader(const WaveHeader& header) { m_header = header; }
+
+    U32 size() const { return m_size; }
+    const S16* samples() const { return m_samples.data(); }
+    S16* samples() { return m_samples.data(); }
+    double timeStart() const { return m_timeStart; }
+    double timeStep() const { return m_timeStep; }
+    const WaveHeader& header() const { return m_header; }
+
+    // 按需计算的 float / double 视图
+    WaveAxisView<float> amplitudesF() const { return {m_samples.data(), 0.0f, 0.0f, m_size}; }
+    WaveAxisView<double> amplitudes() const { return {m_samples.data(), 0.0, 0.0, m_size}; }
+    WaveAxisView<float> timesF() const {
+        return {nullptr, static_cast<float>(m_timeStart), static_cast<float>(m_timeStep), m_size};
+    }
+    WaveAxisView<double> times() const { return {nullptr, m_timeStart, m_timeStep, m_size}; }
+
+    // 批量转换到调用者的缓冲区，dst 至少 size() 个元素
+    void copyAmplitudes(float* dst) const { convertSamples(m_samples.data(), dst, m_size); }
+    void copyAmplitudes(double* dst) const { convertSamples(m_samples.data(), dst, m_size); }
+
+    // 由当前采样点重建金字塔（发布前调用，预分配的内存内完成）
+    void buildPyramid();
+
+    // 时间区间 [t0, t1)（us）按 pixels 个像素取包络，返回像素数；开销 O(pixels × log 采样点数)
+    U32 envelope(double t0, double t1, U32 pixels, std::vector<MinMaxPair<S16>>& out) const;
+
+    // 转换为界面使用的点列形式
+    void toDisplayData(DISPLAY_WAVE_DATA& wave) const;
+};
+
+
+#endif /*__WAVE_BUFFER_H__*/
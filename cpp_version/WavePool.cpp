@@ -0,0 +1,59 @@
+#include "WavePool.h"
+
+
+// 构造函数
+WavePool::WavePool(U32 size)
+    : m_slots(new WaveSlot[size < 2 ? 2 : size]),
+      m_size(size < 2 ? 2 : size),
+      m_current(nullptr),
+      m_exhaustedCount(0) {
+}
+
+// 析构函数
+WavePool::~WavePool() {
+    WaveSlot* current = m_current.exchange(nullptr, std::memory_order_acq_rel);
+    if (current != nullptr) {
+        current->refs.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+// 取空闲缓冲区：只有引用计数从 0 改为 1 成功的缓冲区才交给填充方，
+// 读取方对空闲缓冲区的短暂计数会使这里跳过该缓冲区，不会与读取方冲突
+WaveHandle WavePool::acquire() {
+    for (U32 i = 0; i < m_size; ++i) {
+        U32 expected = 0;
+        if (m_slots[i].refs.compare_exchange_strong(expected, 1, std::memory_order_acquire,
+                                                    std::memory_order_relaxed)) {
+            return WaveHandle(&m_slots[i]);
+        }
+    }
+    m_exhaustedCount.fetch_add(1, std::memory_order_relaxed);
+    return WaveHandle();
+}
+
+// 发布：填充方的引用转为池的引用，旧波形的引用由池释放
+void WavePool::publish(WaveHandle wave) {
+    WaveSlot* slot = wave.detach();
+    if (slot == nullptr) {
+        return;
+    }
+    WaveSlot* previous = m_current.exchange(slot, std::memory_order_acq_rel);
+    if (previous != nullptr) {
+        previous->refs.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+// 取当前波形：先增加计数再确认它仍是当前波形，确认失败说明已被替换（可能正被重新填充），撤销后重试
+WaveHandle WavePool::current() const {
+    for (;;) {
+        WaveSlot* slot = m_current.load(std::memory_order_acquire);
+        if (slot == nullptr) {
+            return WaveHandle();
+        }
+        slot->refs.fetch_add(1, std::memory_order_acq_rel);
+        if (m_current.load(std::memory_order_acquire) == slot) {
+            return WaveHandle(slot);
+        }
+        slot->refs.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef __WAVE_POOL_H__
+#define __WAVE_POOL_H__
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include "WaveBuffer.h"
+
+
+// 使用 C++ using 别名替代 typedef
+using U32 = uint32_t;
+
+constexpr U32 WAVE_POOL_SIZE = 4; // 默认缓冲区数：当前发布、正在填充各一个，其余供读取方持有
+
+// 池中的波形缓冲区及其引用计数
+struct alignas(64) WaveSlot {
+    WaveBuffer wave;
+    std::atomic<U32> refs{0}; // 0 表示空闲
+};
+
+// 池中波形的引用：复制时增加引用计数，析构时减少，计数归零后缓冲区可被重新填充。
+// 读取方拿到的波形不会再被修改；句柄需在所属 WavePool 析构之前释放
+class WaveHandle {
+private:
+    WaveSlot* m_slot;
+
+    friend class WavePool;
+    explicit WaveHandle(WaveSlot* slot) : m_slot(slot) {}
+
+    // 交出引用而不减少计数
+    WaveSlot* detach() {
+        WaveSlot* slot = m_slot;
+        m_slot = nullptr;
+        return slot;
+    }
+
+public:
+    WaveHandle() : m_slot(nullptr) {}
+    WaveHandle(const WaveHandle& other) : m_slot(other.m_slot) {
+        if (m_slot != nullptr) {
+            m_slot->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    WaveHandle(WaveHandle&& other) noexcept : m_slot(other.detach()) {}
+    WaveHandle& operator=(WaveHandle other) noexcept {
+        std::swap(m_slot, other.m_slot);
+        return *this;
+    }
+    ~WaveHandle() { reset(); }
+
+    // 释放引用
+    void reset() {
+        if (m_slot != nullptr) {
+            m_slot->refs.fetch_sub(1, std::memory_order_acq_rel);
+            m_slot = nullptr;
+        }
+    }
+
+    explicit operator bool() const { return m_slot != nullptr; }
+    const WaveBuffer& operator*() const { return m_slot->wave; }
+    const WaveBuffer* operator->() const { return &m_slot->wave; }
+    const WaveBuffer* get() const { return m_slot != nullptr ? &m_slot->wave : nullptr; }
+
+    // 填充方独占时可写（acquire 得到、尚未发布的缓冲区）
+    WaveBuffer* mutableWave() { return m_slot != nullptr ? &m_slot->wave : nullptr; }
+};
+
+// 波形发布池：填充方从池中取空闲缓冲区（后台缓冲区）写入，完成后一次原子交换发布；
+// 读取方无锁取得当前波形的引用，不复制数据。缓冲区固定预分配，稳定运行时不分配内存
+class WavePool {
+private:
+    std::unique_ptr<WaveSlot[]> m_slots;   // 缓冲区
+    U32 m_size;                            // 缓冲区数
+    std::atomic<WaveSlot*> m_current;      // 当前发布的波形（池持有一个引用）
+    std::atomic<U32> m_exhaustedCount;     // 没有空闲缓冲区的次数
+
+public:
+    explicit WavePool(U32 size = WAVE_POOL_SIZE);
+    ~WavePool();
+
+    // 禁止拷贝构造和赋值操作
+    WavePool(const WavePool&) = delete;
+    WavePool& operator=(const WavePool&) = delete;
+
+    // 取一个空闲缓冲区供填充，全部被占用时返回空句柄
+    WaveHandle acquire();
+
+    // 发布填充完成的缓冲区，替换当前波形；发布后不得再修改
+    void publish(WaveHandle wave);
+
+    // 当前波形，尚未发布时返回空句柄；无锁
+    WaveHandle current() const;
+
+    // 没有空闲缓冲区的次数（读取方持有波形过久时增加）
+    U32 getExhaustedCount() const { return m_exhaustedCount.load(std::memory_order_relaxed); }
+};
+
+
+#endif /*__WAVE_POOL_H__*/
@@ -1,36 +1,34 @@
 #include "emat_communicater.h"
+#include "FrameAwaiter.h"
 #include <QDebug>
 
 
 // C++实现的帧处理回调函数
 
-    S32 ProcParam(const std::vector<U8>& frame, U32 len)
+    S32 EmatCommunicater::ProcParam(const std::vector<U8>& frame, U32 len)
     {
-        auto cmd=EmatCommunicater::instance().m_commandQueue.front();
         qDebug() << "ProcParam";
         if(frame[1]==0x55){
             //读取参数
             if(frame[2]==0xFF){
                 qDebug() << "ProcParam Read All Params";
+                // 先解析到局部参数组，再整组写入缓存，读取方不会看到更新一半的参数
+                DEVICE_ULTRA_PARAM_U params;
                 for (int i = 0; i < PARAM_SIZE; i++)
                 {
-                    // EmatCommunicater::instance().mDeviceParam.arrParam[i].index = i;
-                    EmatCommunicater::instance().mDeviceParam.arrParam[i].value = frame[2*i+3]<<8 | frame[2*i+4];
-                    qDebug() << "Param Index:"<<i<<" Value:"<<EmatCommunicater::instance().mDeviceParam.arrParam[i].value;
-                }
-                if(cmd[4]==0x11&&cmd[5]==0x55&&cmd[6]==frame[2]){
-                    EmatCommunicater::instance().m_commandQueue.pop();
+                    params.arrParam[i].index = i;
+                    params.arrParam[i].value = frame[2*i+3]<<8 | frame[2*i+4];
+                    qDebug() << "Param Index:"<<i<<" Value:"<<params.arrParam[i].value;
                 }
+                m_paramCache.confirmAll(params, monotonicNowNs());
             }
             else{
                 qDebug() << "ProcParam Read Param Index:"<<int(frame[2])<<" Value:"<<(frame[3]<<8 | frame[4]);
+                m_paramCache.confirm(frame[2], (INT16)(frame[3]<<8 | frame[4]), monotonicNowNs());
             }
 
         }
         else if(frame[1]==0xAA){
-            if(cmd[4]==0x11&&cmd[5]==0xAA&&cmd[6]==frame[2]){
-                EmatCommunicater::instance().m_commandQueue.pop();
-            }
             //写入参数
         }
         else if(frame[1]==0x5A){
@@ -38,71 +36,148 @@
         }
         return 1; // 成功处理
     }
-    S32 ProcWave(const std::vector<U8>& frame, U32 len)
+    S32 EmatCommunicater::ProcWave(const std::vector<U8>& frame, U32 len)
     {
         // qDebug() << "ProcWave";
         //信息帧
-        if(frame[1]==0x00){
+        if(frame[1]==WAVE_INFO_FRAME_NO){
             qDebug() << "ProcWave Info Frame";
-            auto cmd=EmatCommunicater::instance().m_commandQueue.front();
-            if(cmd[4]==0x22){
-                EmatCommunicater::instance().m_commandQueue.pop();
-            }
-            EmatCommunicater::instance().WaveData.thick = float(frame[6]<<8 | frame[7])/1000.0f;
-            EmatCommunicater::instance().WaveData.wave_pos_first = float(frame[8]<<8 | frame[9])/100.0f;
-            EmatCommunicater::instance().WaveData.wave_pos_second = float(frame[10]<<8 | frame[11])/100.0f;
-            EmatCommunicater::instance().WaveData.curGain = float(frame[12]<<8 | frame[13])/10.0f;
-            EmatCommunicater::instance().WaveData.excitation_freq = float(frame[14]<<8 | frame[15])/100.0f;
-            EmatCommunicater::instance().WaveData.measureControlMode = frame[16]<<8 | frame[17];
-            // qDebug() << "ProcWave Thick:"<<EmatCommunicater::instance().WaveData.thick
-            // <<" wave_pos_first:"<<EmatCommunicater::instance().WaveData.wave_pos_first
-            // <<" wave_pos_second:"<<EmatCommunicater::instance().WaveData.wave_pos_second
-            // <<" curGain:"<<EmatCommunicater::instance().WaveData.curGain
-            // <<" excitation_freq:"<<EmatCommunicater::instance().WaveData.excitation_freq
-            // <<" measureControlMode:"<<EmatCommunicater::instance().WaveData.measureControlMode;
-        }
-        //确认帧
-        else if(frame[1]==0xFF){ 
+            m_waveAssembler.onInfo(frame, len);
+        }
+        //确认帧：设备发送完毕，回复接收位图，设备据此补发缺失的数据帧
+        else if(frame[1]==WAVE_ACK_FRAME_NO){
             qDebug() << "ProcWave Ack Frame"<<frame[2];
+            S32 result = m_waveAssembler.onAck(frame, len);
+            if (result == WAVE_RESULT_PENDING) {
+                qDebug() << "ProcWave missing frames" << m_waveAssembler.missingMask();
+            }
+            if (result == WAVE_RESULT_PENDING || result == WAVE_RESULT_COMPLETE) {
+                sendRequest(m_waveAssembler.ackCommand());
+            }
+            if (result == WAVE_RESULT_COMPLETE) {
+                publishWave();
+            }
         }
         //数据帧
         else{
-            qDebug() << "ProcWave Data Frame"<<frame[1];
+            // 数据帧齐全后等待设备的确认帧再回复，避免补发中的帧重复确认
+            if (m_waveAssembler.onData(frame, len) == WAVE_RESULT_INVALID) {
+                qDebug() << "ProcWave invalid data frame"<<frame[1];
+            }
         }
         return 1; // 成功处理
     }
 
-    S32 ProcThkCmd(const std::vector<U8>& frame, U32 len)
+    S32 EmatCommunicater::ProcThkCmd(const std::vector<U8>& frame, U32 len)
     {
-        auto cmd=EmatCommunicater::instance().m_commandQueue.front();
-		qDebug() << "ProcThkCmd";
-        if(frame[1]==0x55 && frame[2]==0x33){
-            if(cmd[4]==0x33 && cmd[5]==0x55){
-                EmatCommunicater::instance().m_commandQueue.pop();
-            }
-        }
-        else if(frame[1]==0xAA && frame[2]==0x33){
-            if(cmd[4]==0x33 && cmd[5]==0xAA){
-                EmatCommunicater::instance().m_commandQueue.pop();
-            }
-            EmatCommunicater::instance().setThickness(0.0);
+        qDebug() << "ProcThkCmd";
+        if(frame[1]==0xAA && frame[2]==0x33){
+            setThickness(0.0);
         }
 
         return 1; // 成功处理
     }
     
-    S32 ProcThickness(const std::vector<U8>& frame, U32 len)
+    // 发布重组完成的波形：设置时间轴后一次原子交换替换当前波形，读取方拿到的波形不会再被修改
+    void EmatCommunicater::publishWave()
     {
+        WaveHandle wave = m_waveAssembler.take();
+        // 时间轴由参数 sendWaveSegment 决定
+        INT16 segment = m_paramCache.value(SEND_WAVE_SEGMENT_INDEX);
+        wave.mutableWave()->setTimeAxis(WAVE_SEGMENT_START_US[segment == 1 ? 1 : 0], WAVE_SEGMENT_SPAN_US / WAVE_POINT_NUM);
+        wave.mutableWave()->buildPyramid();
+        WaveHandle published = wave;
+        m_wavePool.publish(std::move(wave));
+        emit waveReady();
+
+        // 发布后在主机上重新检测回波，核对设备报告的厚度
+        DEVICE_ULTRA_PARAM_U params;
+        m_paramCache.snapshot(params);
+        EchoResult result;
+        m_echoAnalyzer.analyze(*published, EchoAnalyzer::settingsFromParams(params), result);
+        {
+            std::lock_guard<std::mutex> guard(m_echoMutex);
+            m_echoResult = result;
+        }
+        if (result.status == ECHO_RESULT_OK) {
+            emit waveAudited(result.deviceThicknessMm, (float)result.thicknessMm);
+        }
+    }
+
+    S32 EmatCommunicater::ProcThickness(const std::vector<U8>& frame, U32 len)
+    {
+        if (len < THICKNESS_FRAME_LEN) {
+            return 0;
+        }
         float thickness = float(frame[2]<<8 | frame[3])/1000.0f;
         qDebug() << "ProcThickness"<<thickness;
-        EmatCommunicater::instance().setThickness(thickness);
+        U8 seq = frame[1];
+        U16 deviceTs = U16(frame[4]<<8 | frame[5]);
+        U64 hostNs = AsyncFrameDispatcher::currentTiming().rxTime;
+        if (hostNs == 0) {
+            hostNs = monotonicNowNs();
+        }
+        S32 status;
+        {
+            std::lock_guard<std::mutex> guard(m_thicknessMutex);
+            status = m_thicknessSeries.append(hostNs, seq, deviceTs, thickness);
+        }
+        if (status == SERIES_SAMPLE_GAP) {
+            qDebug() << "Thickness sequence gap before" << seq;
+        } else if (status != SERIES_SAMPLE_OK) {
+            return 1; // 重复或迟到的包，不更新显示
+        }
+        if (m_filterResetPending.exchange(false, std::memory_order_acquire)) {
+            m_thicknessFilter.reset();
+        }
+        if (m_filterConfigPending.exchange(false, std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> guard(m_filterConfigMutex);
+            m_thicknessFilter.configure(m_pendingFilterConfig);
+        }
+        float filtered;
+        if (!m_thicknessFilter.process(thickness, filtered)) {
+            m_rejectedThicknessCount.fetch_add(1, std::memory_order_relaxed);
+            return 1; // 离群值，不更新显示
+        }
+        setThickness(filtered);
+        return 1; // 成功处理
+    }
+
+    // 时间校准应答：与在途请求的发送时间、应答到达时间组成一次交换
+    S32 EmatCommunicater::ProcTimeCmd(const std::vector<U8>& frame, U32 len)
+    {
+        if (len < TIME_RESP_LEN || frame[1] != 0xAA) {
+            return 0;
+        }
+        U64 recvNs = AsyncFrameDispatcher::currentTiming().rxTime;
+        if (recvNs == 0) {
+            recvNs = monotonicNowNs();
+        }
+        U64 sendNs = m_syncProbeSendNs.exchange(0);
+        if (sendNs == 0 || recvNs < sendNs || recvNs - sendNs > static_cast<U64>(CLOCK_SYNC_TIMEOUT_MS) * 1000000) {
+            return 1; // 没有在途请求或应答过晚，不能确定对应的发送时间
+        }
+        if (frame[4] != TIME_RESULT_OK) {
+            qDebug() << "Time calibration failed";
+            return 1;
+        }
+        m_clockSync.addSample(sendNs, recvNs, U16(frame[2]<<8 | frame[3]));
         return 1; // 成功处理
     }
 
-    S32 ProcElectriCmd(const std::vector<U8>& frame, U32 len)
+    S32 EmatCommunicater::ProcElectriCmd(const std::vector<U8>& frame, U32 len)
     {
         qDebug() << "ProcElectriCmd";
-        EmatCommunicater::instance().electricValue = INT16(frame[2]<<8 | frame[3]);
+        // 电量应答：命令字、电量（0~100）、时间戳（大端）、填充
+        electricValue = INT16(frame[1]);
+        CoalescedUpdate<INT16> update;
+        U64 deadline;
+        U32 action = m_electricPublisher.offer(electricValue, monotonicNowNs(), update, deadline);
+        if (action == PUBLISH_NOW) {
+            emit electricValueChanged(update.latest, update.min, update.max, static_cast<int>(update.count));
+        } else if (action == PUBLISH_SCHEDULE) {
+            scheduleServiceTimer(PUBLISH_TIMER_ELECTRIC, deadline);
+        }
         return 1; // 成功处理
     }
 
@@ -112,13 +187,23 @@ S32 EmatCommunicater::onDataReceived(const std::vector<U8>& data, S32 length)
 {
     if (!data.empty() && length > 0) {
         // 将数据放入命令帧处理器
-        m_commandFrame.putFrameData(data, length);
+        m_commandFrame.putFrameData(data, length, m_communicator->m_lastReadTime.load(std::memory_order_relaxed));
         // 处理帧
         m_commandFrame.processFrame(true); // true表示异步处理
     }
     return 0;
 }
 
+// 接收许可回调实现：先处理缓冲区中积压的帧，调度器有许可且缓冲区有空间时才继续读取
+bool EmatCommunicater::onReceiveCredit()
+{
+    if (!m_dispatcher->hasCredit()) {
+        return false;
+    }
+    m_commandFrame.processFrame(true);
+    return m_dispatcher->hasCredit() && m_frameBuffer.getAvailableSpace() >= RECV_CREDIT_MIN_SPACE;
+}
+
 // 数据发送回调实现
 void EmatCommunicater::onDataSent(const std::vector<U8>& data, S32 length)
 {
@@ -129,20 +214,65 @@ void EmatCommunicater::onDataSent(const std::vector<U8>& data, S32 length)
     qDebug() << "onDataSent"<<count<<" "<<TotalCount;
 }
 
-bool EmatCommunicater::registerFrameHandler(U8 frameType, S32 (*handler)(const std::vector<U8>& frame, U32 len)) {
-    AsyncFrameDispatcher::getInstance().registerFrameHandler(frameType, handler);
+bool EmatCommunicater::registerFrameHandler(U8 frameType, FrameHandler handler) {
+    m_dispatcher->registerFrameHandler(frameType, std::move(handler));
     return true;
 }
 
+U32 EmatCommunicater::subscribeFrame(U8 frameType, FrameHandler handler, FrameFilter filter, bool async) {
+    return m_dispatcher->subscribe(frameType, std::move(handler), std::move(filter), async);
+}
+
+void EmatCommunicater::unsubscribeFrame(U32 subscriptionId) {
+    m_dispatcher->unsubscribe(subscriptionId);
+}
+
 void EmatCommunicater::initializeCallbacks()
 {
-    registerFrameHandler(0x11, ProcParam); // 处理参数帧类型
-    registerFrameHandler(0x22, ProcWave); // 处理波形帧类型
-    registerFrameHandler(0x33, ProcThkCmd); // 处理电量帧类型
-    registerFrameHandler(0x35, ProcThickness); // 处理厚度数据帧类型
-    registerFrameHandler(0x41, nullptr); // 时间校准
+    using namespace std::placeholders;
+    registerFrameHandler(0x11, std::bind(&EmatCommunicater::ProcParam, this, _1, _2)); // 处理参数帧类型
+    registerFrameHandler(0x22, std::bind(&EmatCommunicater::ProcWave, this, _1, _2)); // 处理波形帧类型
+    registerFrameHandler(0x33, std::bind(&EmatCommunicater::ProcThkCmd, this, _1, _2)); // 处理电量帧类型
+    registerFrameHandler(0x35, std::bind(&EmatCommunicater::ProcThickness, this, _1, _2)); // 处理厚度数据帧类型
+    registerFrameHandler(0x41, std::bind(&EmatCommunicater::ProcTimeCmd, this, _1, _2)); // 时间校准
     registerFrameHandler(0x42, nullptr); // 版本信息
-    registerFrameHandler(0x44, ProcElectriCmd); // 电量信息
+    registerFrameHandler(0x44, std::bind(&EmatCommunicater::ProcElectriCmd, this, _1, _2)); // 电量信息
+
+    // 应答在主处理函数之后交给关联表，完成对应请求
+    for (U8 frameType : {0x11, 0x22, 0x33, 0x41, 0x42, 0x44}) {
+        m_dispatcher->subscribe(frameType, [this](const std::vector<U8>& frame, U32 len) {
+            m_correlator.onResponse(frame, len);
+            return 1;
+        });
+    }
+
+    // 厚度数据逐帧经过滤波和时间序列，不能合并；处理函数会加锁和打印，按队列在处理线程中调用
+    m_dispatcher->setDispatchMode(0x35, DispatchMode::QUEUED);          // 厚度数据
+    // 只关心最新值的帧：处理线程滞后时用新帧覆盖未处理的旧帧
+    m_dispatcher->setDispatchMode(0x44, DispatchMode::CONFLATED);       // 电量信息
+    // 短小且不阻塞的处理函数直接在 I/O 线程中调用，省去跨线程唤醒
+    m_dispatcher->setDispatchMode(0x41, DispatchMode::INLINE);          // 时间校准，应答到达时间不含排队延迟
+
+    // 每帧入队前按时钟估计填写主机对齐时间
+    m_dispatcher->setFrameClock([this](const std::vector<U8>& frame, U32 len, const FrameTiming& timing) {
+        return frameAlignedTime(frame, len, timing);
+    });
+
+    // 过载以事件形式通知界面，不在 I/O 线程中打印
+    m_dispatcher->setOverloadCallback([this](bool overloaded) {
+        emit dispatcherOverloaded(overloaded);
+    });
+
+    // 统计处理函数耗时，超预算时报告（处理函数会访问 Qt 对象，默认不移到隔离执行器）
+    m_dispatcher->setHandlerBudget(HANDLER_BUDGET_NS);
+    m_dispatcher->setBudgetExceededCallback([this](U8 frameType, U64 durationNs) {
+        emit handlerOverBudget(static_cast<int>(frameType), static_cast<qulonglong>(durationNs));
+    });
+
+    // 协程等待超时由重发服务线程的时间轮计时
+    m_dispatcher->setWaiterTimer([this](U64 deadlineNs) {
+        scheduleServiceTimer(WAITER_TIMER, deadlineNs);
+    });
 }
 
 EmatCommunicater& EmatCommunicater::instance() {
@@ -150,14 +280,23 @@ EmatCommunicater& EmatCommunicater::instance() {
     return instance;
 }
 
-EmatCommunicater::EmatCommunicater() : 
-    m_isConnected(false), 
+EmatCommunicater::EmatCommunicater(std::shared_ptr<WorkerPool> workerPool) : 
+    m_workerPool(std::move(workerPool)),
+    m_dispatcher(new AsyncFrameDispatcher(m_workerPool)),
     m_frameBuffer(std::vector<U8>(MAX_RB_LEN, 0)), 
-    m_commandFrame(m_frameBuffer) {
+    m_commandFrame(m_frameBuffer, *m_dispatcher),
+    m_retryWheel(monotonicNowNs()),
+    m_isConnected(false) {
+    // 请求结束时取消其超时定时器并归还窗口额度
+    m_correlator.setCompletionHook([this](U32 requestId) {
+        onRequestCompleted(requestId);
+    });
     // 初始化异步帧调度器
-    AsyncFrameDispatcher::getInstance().init();
+    m_dispatcher->init();
     initializeCallbacks();
-    init_device_param(mDeviceParam);
+    DEVICE_ULTRA_PARAM_U defaults;
+    init_device_param(defaults);
+    m_paramCache.reset(defaults);
 }
 
 EmatCommunicater::~EmatCommunicater() {
@@ -171,7 +310,7 @@ EmatCommunicater::~EmatCommunicater() {
     }
 
     // 反初始化异步帧调度器
-    AsyncFrameDispatcher::getInstance().uninit();
+    m_dispatcher->uninit();
 }
 
 bool EmatCommunicater::connect(ConnectionType type, const std::string& comPort, int baudRate, int timeoutMS) {
@@ -192,66 +331,327 @@ bool EmatCommunicater::connect(ConnectionType type, const std::string& comPort,
     m_communicator->setDataSentCallback(
         std::bind(&EmatCommunicater::onDataSent, this, std::placeholders::_1, std::placeholders::_2)
     );
+    m_communicator->setReceiveCreditCallback(
+        std::bind(&EmatCommunicater::onReceiveCredit, this)
+    );
     if(!m_communicator->connect(comPort, baudRate, timeoutMS)) {
         return false;
     }
     StartReceiveThread();
     
     m_isConnected = true;
+    // 设备重新连接后时间戳可能重新开始，重新同步
+    m_clockSync.reset();
+    resetThicknessState();
+    m_syncProbeSendNs = 0;
+    m_syncProbeCount = 0;
+    scheduleServiceTimer(CLOCK_SYNC_TIMER, monotonicNowNs());
     return m_isConnected;
 }
 
 void EmatCommunicater::disconnect() {
-
+    // 先标记断开，之后发起的请求立即以取消结束
+    m_isConnected = false;
     StopReceiveThread();
+    // 断开后不会再有应答，结束所有排队和在途的请求
+    cancelPendingCommands();
     // 断开连接逻辑
     m_communicator->disconnect();
-    m_isConnected = false;
 }
 
 void EmatCommunicater::ProcessReceivedData() {
-    // 由于使用了回调函数处理数据，这里的实现可能需要简化或调整
-    // 具体取决于项目需求
-    // while(recieveThreadRunning) {
-    //     m_commandFrame.processFrame(true); // true表示异步处理
-    // }
+    std::vector<U32> expired;
+    std::unique_lock<std::mutex> lock(m_retryMutex);
     while(recieveThreadRunning) {
-        while(!m_commandQueue.empty()){
-            auto cmd = m_commandQueue.front();
-            m_communicator->sendCommand(cmd);
-            Sleep(50); // 等待50ms,确保命令发送完成
+        // 睡眠到最早的超时时间，没有在途命令时一直等待
+        U64 deadline = m_retryWheel.nextDeadline();
+        if (deadline == 0) {
+            m_retryCondition.wait(lock);
+        } else {
+            m_retryCondition.wait_until(lock, std::chrono::steady_clock::time_point(std::chrono::nanoseconds(deadline)));
+        }
+        expired.clear();
+        m_retryWheel.advance(monotonicNowNs(), expired);
+        if (expired.empty()) {
+            continue;
+        }
+        lock.unlock(); // 重发前解锁
+        for (U32 key : expired) {
+            if (key == CLOCK_SYNC_TIMER) {
+                onClockSyncTimer();
+            } else if (key == WAITER_TIMER) {
+                m_dispatcher->expireWaiters(monotonicNowNs());
+            } else if (key >= REQUEST_ID_LIMIT) {
+                onPublishTimer(key);
+            } else {
+                onRetryTimer(key);
+            }
+        }
+        lock.lock();
+    }
+}
+
+// 处理超时的命令：未达重发上限时重发并按退避时间重新计时，否则以超时结束
+void EmatCommunicater::onRetryTimer(U32 requestId) {
+    std::vector<U8> Frm;
+    U32 attempt = 0;
+    U32 maxRetries;
+    {
+        std::lock_guard<std::mutex> guard(m_retryMutex);
+        maxRetries = m_retryPolicy.maxRetries;
+    }
+    if (m_correlator.retry(requestId, maxRetries, Frm, attempt)) {
+        {
+            std::lock_guard<std::mutex> guard(m_retryMutex);
+            U64 now = monotonicNowNs();
+            m_retryWheel.schedule(requestId, now + retryTimeoutNs(attempt), now);
         }
-        Sleep(500); // 等待500ms
+        m_communicator->sendCommand(Frm);
+    } else if (m_correlator.fail(requestId, CMD_RESULT_TIMEOUT)) {
+        qDebug() << "Command timeout, request" << requestId;
     }
 }
 
-// 启动接收线程（可能需要根据新的设计调整）
+// 第 attempt 次发送后的应答超时时间（需持有 m_retryMutex）
+U64 EmatCommunicater::retryTimeoutNs(U32 attempt) const {
+    U64 timeoutMs = m_retryPolicy.timeoutMs;
+    for (U32 i = 0; i < attempt && timeoutMs < m_retryPolicy.maxTimeoutMs; ++i) {
+        timeoutMs *= m_retryPolicy.backoff;
+    }
+    if (timeoutMs > m_retryPolicy.maxTimeoutMs) {
+        timeoutMs = m_retryPolicy.maxTimeoutMs;
+    }
+    return timeoutMs * 1000000ull;
+}
+
+// 设置命令重发策略
+void EmatCommunicater::setRetryPolicy(const RetryPolicy& policy) {
+    std::lock_guard<std::mutex> guard(m_retryMutex);
+    m_retryPolicy = policy;
+}
+
+// 启动重发服务线程
 void EmatCommunicater::StartReceiveThread() {
-    recieveThreadRunning = true;
     if (!receiveThread.joinable()) {
+        recieveThreadRunning = true;
         receiveThread = std::thread(&EmatCommunicater::ProcessReceivedData, this);
-        receiveThread.detach();
     }
 }
 
-// 停止接收线程
+// 停止重发服务线程
 void EmatCommunicater::StopReceiveThread() {
-    recieveThreadRunning = false;
+    {
+        std::lock_guard<std::mutex> guard(m_retryMutex);
+        recieveThreadRunning = false;
+    }
+    m_retryCondition.notify_all();
     if (receiveThread.joinable()) {
         receiveThread.join();
     }
+    // 服务线程退出后发布尚未到期的合并数据
+    {
+        std::lock_guard<std::mutex> guard(m_retryMutex);
+        m_retryWheel.cancel(PUBLISH_TIMER_THICKNESS);
+        m_retryWheel.cancel(PUBLISH_TIMER_ELECTRIC);
+        m_retryWheel.cancel(CLOCK_SYNC_TIMER);
+    }
+    onPublishTimer(PUBLISH_TIMER_THICKNESS);
+    onPublishTimer(PUBLISH_TIMER_ELECTRIC);
+}
+
+// 发送业务命令：需要应答的命令进入发送队列，在途命令数小于窗口大小时立即发出，
+// 不需要应答的命令（如确认反馈）直接发送
+std::future<CommandResult> EmatCommunicater::sendRequest(const std::vector<U8>& cmd, ResponseCallback callback,
+                                                         CommandPriority priority) {
+    auto promise = std::make_shared<std::promise<CommandResult>>();
+    std::future<CommandResult> result = promise->get_future();
+    // 断开后不会再有应答，重发服务线程也已停止，不登记新的请求
+    if (cmd.empty() || !m_communicator || !m_isConnected) {
+        promise->set_value({CMD_RESULT_CANCELLED, std::vector<U8>()});
+        if (callback) {
+            callback(CMD_RESULT_CANCELLED, std::vector<U8>(), 0);
+        }
+        return result;
+    }
+    CorrelationKey key;
+    if (!CommandCorrelator::keyOfCommand(cmd, key)) {
+        std::vector<U8> Frm(cmd.size() + uFRAME_HE_ND_LEN, 0);
+        // 转换命令为帧
+        CommandFrame::cmdToFrame(Frm, cmd, static_cast<U16>(cmd.size()));
+        // 发送命令，发送即完成
+        m_communicator->sendCommand(Frm);
+        promise->set_value({CMD_RESULT_OK, std::vector<U8>()});
+        if (callback) {
+            callback(CMD_RESULT_OK, std::vector<U8>(), 0);
+        }
+        return result;
+    }
+    {
+        std::lock_guard<std::mutex> guard(m_sendMutex);
+        OutgoingCommand command{cmd, key, {}};
+        U32 level = coalesceLocked(command, static_cast<U32>(priority));
+        command.waiters.push_back({promise, std::move(callback)});
+        m_sendQueues[level].push_back(std::move(command));
+    }
+    pumpSendQueue();
+    return result;
+}
+
+// 与排队中的同类命令合并：移除排队中关联键相同的旧命令，其调用者并入新命令，
+// 新命令排在队尾，保证最新的命令不会越过在它之前发起的其他命令；返回新命令应进入的优先级
+U32 EmatCommunicater::coalesceLocked(OutgoingCommand& command, U32 level) {
+    for (U32 i = 0; i < COMMAND_PRIORITY_COUNT; ++i) {
+        auto& queue = m_sendQueues[i];
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            if (!(it->key == command.key)) {
+                continue;
+            }
+            // 同一关联键最多只有一条排队命令
+            command.waiters = std::move(it->waiters);
+            queue.erase(it);
+            m_coalescedCount.fetch_add(1, std::memory_order_relaxed);
+            return i < level ? i : level;
+        }
+    }
+    return level;
+}
+
+// 在窗口额度内按优先级发出排队的命令
+void EmatCommunicater::pumpSendQueue() {
+    {
+        std::lock_guard<std::mutex> guard(m_sendMutex);
+        while (m_isConnected && m_inFlight < m_windowSize && m_communicator) {
+            std::deque<OutgoingCommand>* queue = nullptr;
+            for (auto& candidate : m_sendQueues) {
+                if (!candidate.empty()) {
+                    queue = &candidate;
+                    break;
+                }
+            }
+            if (queue == nullptr) {
+                break;
+            }
+            OutgoingCommand command = std::move(queue->front());
+            queue->pop_front();
+            transmitLocked(command);
+        }
+        if (m_isConnected) {
+            return;
+        }
+    }
+    // 与断开并发进入队列的命令不会再发出，以取消结束
+    cancelQueuedCommands();
+}
+
+// 编码并发出一条需要应答的命令，占用一个窗口额度（需持有 m_sendMutex，保证发出顺序与出队顺序一致）
+void EmatCommunicater::transmitLocked(OutgoingCommand& command) {
+    std::vector<U8> Frm(command.cmd.size() + uFRAME_HE_ND_LEN, 0);
+    // 转换命令为帧
+    CommandFrame::cmdToFrame(Frm, command.cmd, static_cast<U16>(command.cmd.size()));
+    U64 now = monotonicNowNs();
+    std::shared_ptr<std::promise<CommandResult>> promise;
+    ResponseCallback callback;
+    if (command.waiters.size() == 1) {
+        promise = std::move(command.waiters[0].promise);
+        callback = std::move(command.waiters[0].callback);
+    } else {
+        // 合并后的命令，应答时依次完成每个调用者
+        auto waiters = std::make_shared<std::vector<CommandWaiter>>(std::move(command.waiters));
+        callback = [waiters](S32 status, const std::vector<U8>& frame, U32 len) {
+            for (auto& waiter : *waiters) {
+                waiter.promise->set_value({status, std::vector<U8>(frame.begin(), frame.begin() + len)});
+                if (waiter.callback) {
+                    waiter.callback(status, frame, len);
+                }
+            }
+        };
+    }
+    U32 requestId = m_correlator.track(command.cmd, Frm, now, std::move(promise), std::move(callback));
+    ++m_inFlight;
+    // 登记应答超时时间，唤醒重发服务线程重新计算睡眠时间
+    {
+        std::lock_guard<std::mutex> guard(m_retryMutex);
+        m_retryWheel.schedule(requestId, now + retryTimeoutNs(0), now);
+    }
+    m_retryCondition.notify_one();
+    // 发送命令
+    m_communicator->sendCommand(Frm);
+}
+
+// 请求结束：取消超时定时器，归还窗口额度并发出下一条排队的命令
+void EmatCommunicater::onRequestCompleted(U32 requestId) {
+    {
+        std::lock_guard<std::mutex> guard(m_retryMutex);
+        m_retryWheel.cancel(requestId);
+    }
+    {
+        std::lock_guard<std::mutex> guard(m_sendMutex);
+        if (m_inFlight > 0) {
+            --m_inFlight;
+        }
+    }
+    pumpSendQueue();
+}
+
+// 设置在途命令窗口大小
+void EmatCommunicater::setWindowSize(U32 windowSize) {
+    {
+        std::lock_guard<std::mutex> guard(m_sendMutex);
+        m_windowSize = windowSize > 0 ? windowSize : 1;
+    }
+    pumpSendQueue();
+}
+
+// 清空厚度时间序列；滤波只在帧调度器中访问，由其在处理下一个厚度数据前清空
+void EmatCommunicater::resetThicknessState() {
+    {
+        std::lock_guard<std::mutex> guard(m_thicknessMutex);
+        m_thicknessSeries.reset();
+    }
+    m_filterResetPending.store(true, std::memory_order_release);
+}
+
+// 以取消结束所有排队的命令
+void EmatCommunicater::cancelQueuedCommands() {
+    std::array<std::deque<OutgoingCommand>, COMMAND_PRIORITY_COUNT> queued;
+    {
+        std::lock_guard<std::mutex> guard(m_sendMutex);
+        queued.swap(m_sendQueues);
+    }
+    for (auto& queue : queued) {
+        for (auto& command : queue) {
+            for (auto& waiter : command.waiters) {
+                waiter.promise->set_value({CMD_RESULT_CANCELLED, std::vector<U8>()});
+                if (waiter.callback) {
+                    waiter.callback(CMD_RESULT_CANCELLED, std::vector<U8>(), 0);
+                }
+            }
+        }
+    }
 }
 
+// 结束所有排队和在途的命令
+void EmatCommunicater::cancelPendingCommands() {
+    cancelQueuedCommands();
+    m_correlator.cancelAll();
+}
+
+#ifdef FRAME_AWAITER_AVAILABLE
+// 发送业务命令并等待应答
+FrameAwaitable EmatCommunicater::request(const std::vector<U8>& cmd) {
+    return FrameAwaitable([this, cmd](FrameWaitCallback callback) {
+        sendRequest(cmd, [callback](S32 status, const std::vector<U8>& frame, U32 len) {
+            callback(frame, len);
+        });
+    }, m_dispatcher->getResumeScheduler());
+}
+#endif
+
 // 发送开始厚度测量指令
 void EmatCommunicater::StartThicknessCmd() {
-    U16 nSendLen = 0;
     std::vector<U8> nData = {0x33,0x55,0x00,0x00};
-     std::vector<U8> Frm(10, 0);
-    // 转换命令为帧
-    nSendLen = CommandFrame::cmdToFrame(Frm, nData, 4);
-    m_commandQueue.push(Frm);
     // 发送命令
-    m_communicator->sendCommand(Frm);
+    sendRequest(nData, nullptr, CommandPriority::HIGH);
 }
 
 void EmatCommunicater::StartThickness() {
@@ -259,19 +659,15 @@ void EmatCommunicater::StartThickness() {
         return;
     }
     int count=0;
+    resetThicknessState();
     StartThicknessCmd();
 }
 
 // 发送停止厚度测量指令
 void EmatCommunicater::StopThicknessCmd() {
-    U16 nSendLen = 0;
     std::vector<U8> nData = {0x33,0xAA,0xA5,0xA5};
-    std::vector<U8> Frm(10, 0);
-    // 转换命令为帧
-    nSendLen = CommandFrame::cmdToFrame(Frm, nData, 4);
-    m_commandQueue.push(Frm);
     // 发送命令
-    m_communicator->sendCommand(Frm);
+    sendRequest(nData, nullptr, CommandPriority::HIGH);
 }
 
 void EmatCommunicater::StopThickness() {
@@ -284,92 +680,338 @@ void EmatCommunicater::StopThickness() {
 
 void EmatCommunicater::setThickness(float value) {
     thicknessValue = value;
-    // 触发qt信号,通知界面更新
-    emit thicknessValueChanged(value);
+    {
+        std::lock_guard<std::mutex> guard(m_thicknessMutex);
+        m_thicknessPyramid.append(value);
+    }
+    // 触发qt信号,通知界面更新；发布间隔内的数据合并，由重发服务线程在间隔结束时发布
+    CoalescedUpdate<float> update;
+    U64 deadline;
+    U32 action = m_thicknessPublisher.offer(value, monotonicNowNs(), update, deadline);
+    if (action == PUBLISH_NOW) {
+        emit thicknessValueChanged(update.latest, update.min, update.max, static_cast<int>(update.count));
+    } else if (action == PUBLISH_SCHEDULE) {
+        scheduleServiceTimer(PUBLISH_TIMER_THICKNESS, deadline);
+    }
+}
+
+// 设置时钟同步交换间隔
+void EmatCommunicater::setClockSyncInterval(U32 intervalMs) {
+    m_clockSyncIntervalMs = intervalMs > 0 ? intervalMs : 1;
+}
+
+// 发出时间校准请求：不经过发送窗口和重发，发送时间即写入传输层的时间，重发的应答无法确定往返时间
+void EmatCommunicater::onClockSyncTimer() {
+    if (!m_isConnected || !m_communicator) {
+        return;
+    }
+    U64 now = monotonicNowNs();
+    U16 hostMs = static_cast<U16>(now / 1000000);
+    std::vector<U8> cmd = {0x41, 0x55, static_cast<U8>(hostMs >> 8), static_cast<U8>(hostMs & 0xFF)};
+    std::vector<U8> Frm(cmd.size() + uFRAME_HE_ND_LEN, 0);
+    CommandFrame::cmdToFrame(Frm, cmd, static_cast<U16>(cmd.size()));
+    m_syncProbeSendNs = monotonicNowNs();
+    m_communicator->sendCommand(Frm);
+
+    U32 count = ++m_syncProbeCount;
+    U64 intervalMs = count < CLOCK_SYNC_BURST ? CLOCK_SYNC_BURST_INTERVAL_MS : m_clockSyncIntervalMs.load();
+    scheduleServiceTimer(CLOCK_SYNC_TIMER, now + intervalMs * 1000000);
+}
+
+// 帧的主机对齐时间
+U64 EmatCommunicater::frameAlignedTime(const std::vector<U8>& frame, U32 len, const FrameTiming& timing) const {
+    U64 rxNs = timing.rxTime != 0 ? timing.rxTime : timing.enqueueTime;
+    S32 tsOffset = -1; // 设备时间戳在帧中的位置
+    switch (frame[0]) {
+    case 0x35: // 厚度数据
+        tsOffset = len >= THICKNESS_FRAME_LEN ? 4 : -1;
+        break;
+    case 0x33: // 测厚命令应答
+        tsOffset = len >= 5 ? 3 : -1;
+        break;
+    case 0x41: // 时间校准应答
+        tsOffset = len >= TIME_RESP_LEN && frame[1] == 0xAA ? 2 : -1;
+        break;
+    default:
+        break;
+    }
+    U64 alignedNs;
+    if (tsOffset >= 0 && m_clockSync.toHostNs(U16(frame[tsOffset]<<8 | frame[tsOffset + 1]), rxNs, alignedNs)) {
+        return alignedNs;
+    }
+    ClockEstimate estimate = m_clockSync.estimate();
+    return estimate.synced && rxNs > estimate.minRttNs / 2 ? rxNs - estimate.minRttNs / 2 : rxNs;
+}
+
+// 设置厚度、电量信号的最短发布间隔
+void EmatCommunicater::setPublishInterval(U32 intervalMs) {
+    m_thicknessPublisher.setInterval(static_cast<U64>(intervalMs) * 1000000);
+    m_electricPublisher.setInterval(static_cast<U64>(intervalMs) * 1000000);
+}
+
+// 登记保留键的定时器并唤醒重发服务线程
+void EmatCommunicater::scheduleServiceTimer(U32 timerKey, U64 deadlineNs) {
+    {
+        std::lock_guard<std::mutex> guard(m_retryMutex);
+        m_retryWheel.schedule(timerKey, deadlineNs, monotonicNowNs());
+    }
+    m_retryCondition.notify_one();
+}
+
+// 合并发布定时器到期
+void EmatCommunicater::onPublishTimer(U32 timerKey) {
+    U64 now = monotonicNowNs();
+    if (timerKey == PUBLISH_TIMER_THICKNESS) {
+        CoalescedUpdate<float> update;
+        if (m_thicknessPublisher.flush(now, update)) {
+            emit thicknessValueChanged(update.latest, update.min, update.max, static_cast<int>(update.count));
+        }
+    } else if (timerKey == PUBLISH_TIMER_ELECTRIC) {
+        CoalescedUpdate<INT16> update;
+        if (m_electricPublisher.flush(now, update)) {
+            emit electricValueChanged(update.latest, update.min, update.max, static_cast<int>(update.count));
+        }
+    }
+}
+
+// 设置主机端厚度滤波，由帧调度器在处理下一个厚度数据前应用
+void EmatCommunicater::setThicknessFilter(const ThicknessFilterConfig& config) {
+    std::lock_guard<std::mutex> guard(m_filterConfigMutex);
+    m_pendingFilterConfig = config;
+    m_filterConfigPending.store(true, std::memory_order_release);
+}
+
+// 回波分析结果
+EchoResult EmatCommunicater::getEchoResult() {
+    std::lock_guard<std::mutex> guard(m_echoMutex);
+    return m_echoResult;
+}
+
+// 厚度历史范围
+void EmatCommunicater::getThicknessHistoryRange(U64& begin, U64& end) {
+    std::lock_guard<std::mutex> guard(m_thicknessMutex);
+    begin = m_thicknessPyramid.begin();
+    end = m_thicknessPyramid.end();
+}
+
+// 厚度历史包络
+U32 EmatCommunicater::getThicknessEnvelope(U64 first, U64 last, U32 pixels, std::vector<MinMaxPair<float>>& out) {
+    std::lock_guard<std::mutex> guard(m_thicknessMutex);
+    return m_thicknessPyramid.envelope(first, last, pixels, out);
+}
+
+// 厚度时间序列窗口内的样本
+U32 EmatCommunicater::getThicknessSamples(U64 fromNs, U64 toNs, std::vector<ThicknessSample>& out) {
+    std::lock_guard<std::mutex> guard(m_thicknessMutex);
+    return m_thicknessSeries.query(fromNs, toNs, out);
+}
+
+// 厚度时间序列窗口统计
+SeriesWindow EmatCommunicater::getThicknessWindow(U64 fromNs, U64 toNs) {
+    std::lock_guard<std::mutex> guard(m_thicknessMutex);
+    return m_thicknessSeries.window(fromNs, toNs);
+}
+
+// 厚度数据累计统计
+SeriesStats EmatCommunicater::getThicknessSeriesStats() {
+    std::lock_guard<std::mutex> guard(m_thicknessMutex);
+    return m_thicknessSeries.stats();
 }
 
 // 获取波形
 void EmatCommunicater::GetWave() {
-    U16 nSendLen = 0;
     std::vector<U8> nData = {0x22,0x55,0xA5,0xA5,0xA5,0xA5};
-    std::vector<U8> Frm(12, 0);
-    // 转换命令为帧
-    nSendLen = CommandFrame::cmdToFrame(Frm, nData, 6);
-    m_commandQueue.push(Frm);
     // 发送命令
-    m_communicator->sendCommand(Frm);
+    sendRequest(nData);
 }
 
 // 获取电量
 void EmatCommunicater::GetElectric() {
-    U16 nSendLen = 0;
     std::vector<U8> nData = {0x44,0x00,0x00,0xA5};
-    std::vector<U8> Frm(10, 0);
-    // 转换命令为帧
-    nSendLen = CommandFrame::cmdToFrame(Frm, nData, 4);
-    m_commandQueue.push(Frm);
     // 发送命令
-    m_communicator->sendCommand(Frm);
+    sendRequest(nData, nullptr, CommandPriority::LOW);
 }
 
 void EmatCommunicater::GetVersion() {
-    U16 nSendLen = 0;
     std::vector<U8> nData = {0x42,0x55,0x00,0xA5};
-    std::vector<U8> Frm(10, 0);
-    // 转换命令为帧
-    nSendLen = CommandFrame::cmdToFrame(Frm, nData, 4);
-    m_commandQueue.push(Frm);
     // 发送命令
-    m_communicator->sendCommand(Frm);
+    sendRequest(nData, nullptr, CommandPriority::LOW);
 }
 
 // 重置参数
 void EmatCommunicater::ResetParma() {
-    U16 nSendLen = 0;
     std::vector<U8> nData = {0x11,0x5A,0xFF,0xA5};
-    std::vector<U8> Frm(10, 0);
-    // 转换命令为帧
-    nSendLen = CommandFrame::cmdToFrame(Frm, nData, 4);
-    m_commandQueue.push(Frm);
-    // 发送命令
-    m_communicator->sendCommand(Frm);
+    // 发送命令，重置成功后缓存恢复为默认参数，下次读取时重新从设备获取
+    sendRequest(nData, [this](S32 status, const std::vector<U8>& frame, U32 len) {
+        // 设备返回重置失败时缓存保持不变
+        if (paramWriteStatus(status, frame, len) == CMD_RESULT_OK) {
+            DEVICE_ULTRA_PARAM_U defaults;
+            init_device_param(defaults);
+            m_paramCache.reset(defaults);
+        }
+    });
 }
 
 //修改单个参数
 void EmatCommunicater::SendParam(int index, int value) {
-    U16 nSendLen = 0;
-    //value写入两个字节
-    std::vector<U8> nData = {0x11,0xAA,(U8)index,(U8)(value >> 8),(U8)(value & 0xFF),0x1A};
-    std::vector<U8> Frm(12, 0);
-    // 转换命令为帧
-    nSendLen = CommandFrame::cmdToFrame(Frm, nData, 6);
-    m_commandQueue.push(Frm);
-    // 发送命令
-    m_communicator->sendCommand(Frm);
+    std::vector<U8> nData = paramWriteCmd((U8)index, (INT16)value);
+    // 发送命令，确认前该参数视为不新鲜
+    m_paramCache.markDirty(index, monotonicNowNs());
+    sendRequest(nData, [this, index, value](S32 status, const std::vector<U8>& frame, U32 len) {
+        // 设备返回写入失败时与超时相同，缓存值保持为设备最近确认的值
+        if (paramWriteStatus(status, frame, len) == CMD_RESULT_OK) {
+            m_paramCache.confirm(index, (INT16)value, monotonicNowNs());
+        } else {
+            m_paramCache.clearDirty(index);
+        }
+    });
+}
+
+// 设备参数快照
+DEVICE_ULTRA_PARAM_U EmatCommunicater::getDeviceParam() const {
+    DEVICE_ULTRA_PARAM_U params;
+    m_paramCache.snapshot(params);
+    return params;
+}
+
+// 单个参数写入命令，value写入两个字节
+std::vector<U8> EmatCommunicater::paramWriteCmd(U8 index, INT16 value) {
+    return {0x11,0xAA,index,(U8)(value >> 8),(U8)(value & 0xFF),0x1A};
+}
+
+// 参数写入/重置应答的结果（sPara6BResp：frame[3] 为 0x33 成功，0xCC 失败）
+S32 EmatCommunicater::paramWriteStatus(S32 status, const std::vector<U8>& frame, U32 len) {
+    if (status != CMD_RESULT_OK) {
+        return status;
+    }
+    return len > 3 && frame[3] == PARAM_RESULT_OK ? CMD_RESULT_OK : CMD_RESULT_REJECTED;
+}
+
+// 参数事务
+std::future<CommandResult> EmatCommunicater::writeParams(const DEVICE_ULTRA_PARAM_U& desired, ResponseCallback callback) {
+    DEVICE_ULTRA_PARAM_U current;
+    m_paramCache.snapshot(current);
+    std::vector<U8> changed;
+    for (int i = 0; i < PARAM_SIZE; i++) {
+        // 从未经设备确认的参数缓存值只是默认值，与设备实际值未必一致，也需写入
+        if (desired.arrParam[i].value != current.arrParam[i].value || m_paramCache.state(i).confirmedTime == 0) {
+            changed.push_back((U8)i);
+        }
+    }
+    if (changed.empty()) {
+        // 与缓存一致，不需要访问设备
+        std::promise<CommandResult> promise;
+        promise.set_value({CMD_RESULT_OK, std::vector<U8>()});
+        if (callback) {
+            callback(CMD_RESULT_OK, std::vector<U8>(), 0);
+        }
+        return promise.get_future();
+    }
+
+    // 确认前变化的参数视为不新鲜，结束时已确认的参数写入缓存，其余清除未确认标记
+    U64 now = monotonicNowNs();
+    for (U8 index : changed) {
+        m_paramCache.markDirty(index, now);
+    }
+    auto commit = [this, desired, changed](const std::vector<U8>& indexes) {
+        U64 confirmTime = monotonicNowNs();
+        for (U8 index : indexes) {
+            m_paramCache.confirm(index, desired.arrParam[index].value, confirmTime);
+        }
+        for (U8 index : changed) {
+            m_paramCache.clearDirty(index);
+        }
+    };
+
+    U32 singleBytes = static_cast<U32>(changed.size()) * (PARAM_WRITE_FRAME_LEN + PARAM_WRITE_ACK_LEN);
+    U32 bulkBytes = PARAM_WRITE_ALL_FRAME_LEN + PARAM_WRITE_ACK_LEN;
+    if (bulkBytes < singleBytes) {
+        // 一帧写入全部参数（未变化的参数按缓存值写入），一次应答确认
+        std::vector<U8> nData = {0x11,0xAA,0xFF};
+        for (int i = 0; i < PARAM_SIZE; i++) {
+            U16 value = (U16)desired.arrParam[i].value;
+            nData.push_back((U8)(value >> 8));
+            nData.push_back((U8)(value & 0xFF));
+        }
+        nData.push_back(0xA5);
+        auto promise = std::make_shared<std::promise<CommandResult>>();
+        std::future<CommandResult> result = promise->get_future();
+        sendRequest(nData, [commit, changed, callback, promise](S32 status, const std::vector<U8>& frame, U32 len) {
+            S32 finalStatus = paramWriteStatus(status, frame, len);
+            commit(finalStatus == CMD_RESULT_OK ? changed : std::vector<U8>());
+            promise->set_value({finalStatus, std::vector<U8>(frame.begin(), frame.begin() + len)});
+            if (callback) {
+                callback(finalStatus, frame, len);
+            }
+        });
+        return result;
+    }
+
+    // 逐个写入变化的参数，全部确认后事务完成
+    struct ParamWriteTransaction {
+        std::mutex mutex;
+        U32 remaining;
+        S32 status;
+        std::vector<U8> confirmed;
+        std::promise<CommandResult> promise;
+    };
+    auto transaction = std::make_shared<ParamWriteTransaction>();
+    transaction->remaining = static_cast<U32>(changed.size());
+    transaction->status = CMD_RESULT_OK;
+    std::future<CommandResult> result = transaction->promise.get_future();
+    for (U8 index : changed) {
+        sendRequest(paramWriteCmd(index, desired.arrParam[index].value),
+            [transaction, index, commit, callback](S32 responseStatus, const std::vector<U8>& frame, U32 len) {
+                S32 status = paramWriteStatus(responseStatus, frame, len);
+                std::vector<U8> confirmed;
+                S32 finalStatus;
+                {
+                    std::lock_guard<std::mutex> guard(transaction->mutex);
+                    if (status == CMD_RESULT_OK) {
+                        transaction->confirmed.push_back(index);
+                    } else if (transaction->status == CMD_RESULT_OK) {
+                        transaction->status = status;
+                    }
+                    if (--transaction->remaining > 0) {
+                        return;
+                    }
+                    confirmed.swap(transaction->confirmed);
+                    finalStatus = transaction->status;
+                }
+                // 已确认的参数即使事务失败也已写入设备
+                commit(confirmed);
+                transaction->promise.set_value({finalStatus, std::vector<U8>(frame.begin(), frame.begin() + len)});
+                if (callback) {
+                    callback(finalStatus, frame, len);
+                }
+            });
+    }
+    return result;
 }
 
 //读取单个参数
 void EmatCommunicater::ReadParam(int index){
-    U16 nSendLen = 0;
+    if (m_paramCache.isFresh(index, (U64)PARAM_CACHE_MAX_AGE_MS * 1000000, monotonicNowNs())) {
+        return; // 缓存值仍有效
+    }
     std::vector<U8> nData = {0x11,0x55,(U8)index,0xA5};
-    std::vector<U8> Frm(10, 0);
-    // 转换命令为帧
-    nSendLen = CommandFrame::cmdToFrame(Frm, nData, 4);
-    m_commandQueue.push(Frm);
     // 发送命令
-    m_communicator->sendCommand(Frm);
+    sendRequest(nData, nullptr, CommandPriority::LOW);
 }
 
 //读取所有参数
 void EmatCommunicater::GetAllParam() {
-    U16 nSendLen = 0;
+    U64 now = monotonicNowNs();
+    bool fresh = true;
+    for (U32 i = 0; i < PARAM_SIZE && fresh; i++) {
+        fresh = m_paramCache.isFresh(i, (U64)PARAM_CACHE_MAX_AGE_MS * 1000000, now);
+    }
+    if (fresh) {
+        return; // 缓存中全部参数仍有效
+    }
     std::vector<U8> nData = {0x11,0x55,0xFF,0xA5};
-    std::vector<U8> Frm(10, 0);
-    // 转换命令为帧
-    nSendLen = CommandFrame::cmdToFrame(Frm, nData, 4);
-    m_commandQueue.push(Frm);
     // 发送命令
-    m_communicator->sendCommand(Frm);
+    sendRequest(nData, nullptr, CommandPriority::LOW);
 }
 
 void EmatCommunicater::init_device_param(DEVICE_ULTRA_PARAM_U& deviceParam) {
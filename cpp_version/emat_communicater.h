@@ -5,10 +5,25 @@
 #include "ICommunicator.h" // 添加抽象接口
 #include "AsyncFrame.h"
 #include "CmdFrm.h"
+#include "CommandCorrelator.h"
+#include "TimerWheel.h"
+#include "ParamCache.h"
+#include "WaveAssembler.h"
+#include "MinMaxPyramid.h"
+#include "EchoAnalyzer.h"
+#include "ThicknessFilter.h"
+#include "CoalescingPublisher.h"
+#include "ThicknessSeries.h"
+#include "ClockSync.h"
 #include <QObject>
 #include "paramDefine.h"
 #include <thread>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <array>
+#include <atomic>
 
 
 // 使用 C++ using 别名替代 typedef
@@ -18,17 +33,67 @@ using U32 = uint32_t;
 using S32 = int32_t;
 
 // constexpr U32 MAX_RB_LEN = 0x0400;             // 环形缓存区长度
+constexpr U64 HANDLER_BUDGET_NS = 1000000;        // 帧处理函数单次执行预算（1ms），超出时发出 handlerOverBudget
+constexpr U32 RECV_CREDIT_MIN_SPACE = 0x0400;     // 接收缓冲区剩余空间低于此值时暂停读取（不小于传输层单次读取长度）
+constexpr U32 CMD_RETRY_TIMEOUT_MS = 50;          // 命令首次应答超时
+constexpr U32 CMD_RETRY_BACKOFF = 2;              // 每次重发后超时时间的倍数
+constexpr U32 CMD_RETRY_MAX_TIMEOUT_MS = 800;     // 单次超时时间上限
+constexpr U32 CMD_MAX_RETRIES = 5;                // 最大重发次数，超过后请求以超时结束
+constexpr U32 CMD_WINDOW_SIZE = 4;                // 默认每台设备同时在途的命令数
+constexpr U32 PARAM_WRITE_FRAME_LEN = 12;         // 单个参数写入帧长度（6 字节命令 + 帧头帧尾）
+constexpr U32 PARAM_WRITE_ALL_FRAME_LEN = 78;     // 全部参数写入帧长度（3 + 34*2 + 1 字节命令 + 帧头帧尾）
+constexpr U32 PARAM_WRITE_ACK_LEN = 12;           // 参数写入应答帧长度
+constexpr U8 PARAM_RESULT_OK = 0x33;              // 参数写入/重置应答结果：0x33 成功，0xCC 失败
+constexpr U32 PARAM_CACHE_MAX_AGE_MS = 5000;      // 参数缓存有效期，期内经设备确认的参数读取时不访问设备
+constexpr U32 THICKNESS_HISTORY_CAPACITY = 1u << 20; // 厚度历史金字塔容量，超出后丢弃较早的一半
+constexpr U32 THICKNESS_SERIES_CAPACITY = 1u << 16;  // 厚度时间序列保存的样本数
+constexpr U32 THICKNESS_FRAME_LEN = 6;            // 厚度数据帧：命令字、包序号、厚度（大端）、时间戳（大端）
+constexpr U32 SEND_WAVE_SEGMENT_INDEX = 32;       // 参数 sendWaveSegment 的序号
+constexpr double WAVE_SEGMENT_START_US[2] = {5.0, 14.0}; // 波形段起始时间：0: 5-20us ; 1: 14-29us
+constexpr double WAVE_SEGMENT_SPAN_US = 15.0;     // 波形段时长，WAVE_POINT_NUM 点均匀分布
+constexpr U32 PUBLISH_TIMER_THICKNESS = REQUEST_ID_LIMIT;     // 厚度合并发布定时器（重发时间轮中的保留键）
+constexpr U32 PUBLISH_TIMER_ELECTRIC = REQUEST_ID_LIMIT + 1;  // 电量合并发布定时器
+constexpr U32 CLOCK_SYNC_TIMER = REQUEST_ID_LIMIT + 2;        // 时钟同步定时器
+constexpr U32 WAITER_TIMER = REQUEST_ID_LIMIT + 3;            // 分发器一次性等待者超时定时器
+constexpr U32 CLOCK_SYNC_INTERVAL_MS = 4000;      // 时钟同步交换间隔
+constexpr U32 CLOCK_SYNC_BURST = 8;               // 连接后先以较短间隔交换的次数，尽快得到初始估计
+constexpr U32 CLOCK_SYNC_BURST_INTERVAL_MS = 500; // 连接后的交换间隔
+constexpr U32 CLOCK_SYNC_TIMEOUT_MS = 200;        // 时间校准应答超过此时间到达时丢弃
+constexpr U32 TIME_RESP_LEN = 6;                  // 时间校准应答：命令字、0xAA、时间戳（大端）、结果、填充
+constexpr U8 TIME_RESULT_OK = 0x33;               // 时间校准成功
+
+// 命令发送优先级，高优先级的排队命令先发出
+enum class CommandPriority : U8 {
+    HIGH,    // 控制命令（停止测厚等），抢先于排队的参数读写
+    NORMAL,  // 参数写入、波形请求等
+    LOW,     // 轮询和参数读取
+    COUNT
+};
+constexpr U32 COMMAND_PRIORITY_COUNT = static_cast<U32>(CommandPriority::COUNT);
+
+// 命令重发策略
+struct RetryPolicy {
+    U32 timeoutMs = CMD_RETRY_TIMEOUT_MS;        // 首次应答超时
+    U32 backoff = CMD_RETRY_BACKOFF;             // 退避倍数
+    U32 maxTimeoutMs = CMD_RETRY_MAX_TIMEOUT_MS; // 单次超时上限
+    U32 maxRetries = CMD_MAX_RETRIES;            // 最大重发次数
+};
 // 连接类型枚举
 enum class ConnectionType {
     SERIAL,
     TCP
 };
 
+// 每个设备（测厚仪）一个实例，多个实例可共享同一个工作线程池
 class EmatCommunicater : public QObject
 {
     Q_OBJECT
 public:
-    // 获取单例实例
+    // 构造函数，workerPool 为空时帧调度器使用独立处理线程
+    explicit EmatCommunicater(std::shared_ptr<WorkerPool> workerPool = nullptr);
+    ~EmatCommunicater();
+
+    // 获取默认实例（单设备场景）
     static EmatCommunicater& instance();
 
     // 删除拷贝构造和赋值运算符，防止复制
@@ -36,7 +101,27 @@ public:
     EmatCommunicater& operator=(const EmatCommunicater&) = delete;
 
     void initializeCallbacks();
-    bool registerFrameHandler(U8 frameType, S32 (*handler)(const std::vector<U8>& frame, U32 len));
+    bool registerFrameHandler(U8 frameType, FrameHandler handler);
+
+    // 获取本设备的帧调度器
+    AsyncFrameDispatcher& dispatcher() { return *m_dispatcher; }
+
+    // 订阅帧：日志、记录、界面更新等可分别订阅同一帧类型，返回订阅句柄
+    U32 subscribeFrame(U8 frameType, FrameHandler handler, FrameFilter filter = nullptr, bool async = false);
+    void unsubscribeFrame(U32 subscriptionId);
+
+    // 发送业务命令，应答到达（或请求失败）时完成返回的 future 并调用 callback，可同时有多个请求在途；
+    // 尚未发出的同类命令（关联键相同）被最新的一条取代，所有调用者得到同一结果
+    std::future<CommandResult> sendRequest(const std::vector<U8>& cmd, ResponseCallback callback = nullptr,
+                                           CommandPriority priority = CommandPriority::NORMAL);
+
+    // 获取被合并掉的命令数
+    U32 getCoalescedCount() const { return m_coalescedCount.load(std::memory_order_relaxed); }
+
+#ifdef FRAME_AWAITER_AVAILABLE
+    // 协程接口：co_await comm.request(cmd) 发送业务命令并得到应答帧，失败或超时时为空，需包含 FrameAwaiter.h
+    FrameAwaitable request(const std::vector<U8>& cmd);
+#endif
 
     // 修改连接方法，支持选择连接类型
     bool connect(ConnectionType type, const std::string& address, int portOrBaud, int timeoutMS);
@@ -51,25 +136,84 @@ public:
 
     void GetWave();
     void ResetParma();
+    // 读取参数，缓存中的参数仍新鲜时不访问设备
     void ReadParam(int index);
     void GetElectric();
     void SendParam(int index, int value);
+
+    // 参数事务：与缓存的设备参数比较，只写入变化或从未经设备确认的参数，按传输字节数选择一帧写入全部参数或逐个写入；
+    // 全部写入得到确认后更新缓存并完成返回的 future，任一写入失败（设备返回失败时为 CMD_RESULT_REJECTED）时以该失败状态完成
+    std::future<CommandResult> writeParams(const DEVICE_ULTRA_PARAM_U& desired, ResponseCallback callback = nullptr);
     void GetAllParam();
     
     void GetVersion();
+    // 重发服务线程函数：睡眠到最早的应答超时时间，超时的命令按策略重发或以超时结束
     void ProcessReceivedData();
     void Sendcmd(const U8* pData, S32 dataLength);
     void setThickness(float value);
     float getThickness() const { return thicknessValue; }
+
+    // 厚度历史的序号范围 [begin, end)，序号按收到的厚度数据递增
+    void getThicknessHistoryRange(U64& begin, U64& end);
+
+    // 厚度历史 [first, last) 按 pixels 个像素取最小/最大值包络，返回像素数；开销 O(pixels × log 历史长度)
+    U32 getThicknessEnvelope(U64 first, U64 last, U32 pixels, std::vector<MinMaxPair<float>>& out);
+
+    // 厚度时间序列中主机时间 [fromNs, toNs)（单调时钟）内的原始样本（滤波前）追加到 out，返回个数
+    U32 getThicknessSamples(U64 fromNs, U64 toNs, std::vector<ThicknessSample>& out);
+
+    // 主机时间 [fromNs, toNs) 内的厚度样本数和丢包率
+    SeriesWindow getThicknessWindow(U64 fromNs, U64 toNs);
+
+    // 厚度数据的累计丢包、重复、迟到统计
+    SeriesStats getThicknessSeriesStats();
+
+    // 设备时钟估计（偏移、频偏、往返时间）
+    ClockEstimate getClockEstimate() const { return m_clockSync.estimate(); }
+
+    // 设备时间戳换算为主机单调时钟（ns），nearHostNs 为相近的主机时间；尚未同步时返回 false
+    bool deviceToHostNs(U16 deviceTs, U64 nearHostNs, U64& hostNs) const {
+        return m_clockSync.toHostNs(deviceTs, nearHostNs, hostNs);
+    }
+
+    // 设置时钟同步交换间隔，下一次交换后生效
+    void setClockSyncInterval(U32 intervalMs);
+
+    // 设置厚度、电量信号的最短发布间隔（0 表示每个数据都发布），间隔内的数据合并为一次发布
+    void setPublishInterval(U32 intervalMs);
+
+    // 设置主机端厚度滤波（在下一个厚度数据到达时生效并清空滤波状态），默认不滤波
+    void setThicknessFilter(const ThicknessFilterConfig& config);
+
+    // 被厚度滤波判为离群而丢弃的厚度数据数
+    U64 getRejectedThicknessCount() const { return m_rejectedThicknessCount.load(std::memory_order_relaxed); }
     
     void StartReceiveThread();
     void StopReceiveThread();
 
+    // 设置命令重发策略
+    void setRetryPolicy(const RetryPolicy& policy);
+
+    // 设置同时在途的命令数（至少为 1），应答到达或请求结束时归还额度
+    void setWindowSize(U32 windowSize);
+
     INT16 electricValue = 50; // 当前电量值
 
-    DEVICE_ULTRA_PARAM_U mDeviceParam;//设备参数
+    // 设备参数缓存，帧处理线程写入，界面线程无锁读取
+    const ParamCache& paramCache() const { return m_paramCache; }
+
+    // 读取一致的设备参数快照
+    DEVICE_ULTRA_PARAM_U getDeviceParam() const;
 
-    DISPLAY_WAVE_DATA WaveData;//波形数据
+    // 最近一次重组完成的波形，无锁取得引用，发布后不再修改；需要点列形式时调用 toDisplayData。
+    // 句柄持有期间该缓冲区不会被复用，用完应尽快释放
+    WaveHandle getWave() const { return m_wavePool.current(); }
+
+    // 最近一次主机回波分析的结果（按闸门 1 和声速重新计算的厚度）
+    EchoResult getEchoResult();
+
+    // 因读取方占用全部缓冲区而丢弃的波形数
+    U32 getDroppedWaveCount() const { return m_wavePool.getExhaustedCount(); }
 
     // 数据接收回调函数
     S32 onDataReceived(const std::vector<U8>& data, S32 length);
@@ -77,10 +221,103 @@ public:
     // 数据发送回调函数
     void onDataSent(const std::vector<U8>& data, S32 length);
 
+    // 接收许可回调函数，在接收线程中调用
+    bool onReceiveCredit();
+
+private:
+    // 帧调度器与接收缓冲区需在 m_commandFrame 之前构造
+    std::shared_ptr<WorkerPool> m_workerPool;           // 共享工作线程池
+    std::unique_ptr<AsyncFrameDispatcher> m_dispatcher; // 本设备帧调度器
+    FrameBuffer m_frameBuffer;                          // 用于命令帧处理的缓冲区
+
+public:
     // 命令帧处理器
     CommandFrame m_commandFrame;
 
-    std::queue<std::vector<U8>> m_commandQueue;
+    // 在途命令关联表
+    CommandCorrelator m_correlator;
+
+private:
+    // 命令重发（受 m_retryMutex 保护）
+    std::mutex m_retryMutex;
+    std::condition_variable m_retryCondition; // 新增定时器或停止时唤醒重发服务线程
+    TimerWheel m_retryWheel;                  // 各在途命令的应答超时时间
+    RetryPolicy m_retryPolicy;                // 重发策略
+
+    // 第 attempt 次发送后的应答超时时间（ns）
+    U64 retryTimeoutNs(U32 attempt) const;
+
+    // 处理超时的命令
+    void onRetryTimer(U32 requestId);
+
+    // 厚度、电量信号合并发布
+    CoalescingPublisher<float> m_thicknessPublisher;
+    CoalescingPublisher<INT16> m_electricPublisher;
+
+    // 在重发时间轮中登记保留键的定时器（合并发布、时钟同步）并唤醒重发服务线程
+    void scheduleServiceTimer(U32 timerKey, U64 deadlineNs);
+
+    // 合并发布定时器到期，发布间隔内累积的数据
+    void onPublishTimer(U32 timerKey);
+
+    // 重新连接或重新开始测量：清空厚度时间序列，滤波状态在下一个厚度数据前清空
+    void resetThicknessState();
+
+    // 设备时钟同步
+    ClockSync m_clockSync;
+    std::atomic<U64> m_syncProbeSendNs{0};  // 在途时间校准请求的发送时间，0 表示没有
+    std::atomic<U32> m_syncProbeCount{0};   // 本次连接发出的时间校准请求数
+    std::atomic<U32> m_clockSyncIntervalMs{CLOCK_SYNC_INTERVAL_MS};
+
+    // 时钟同步定时器到期：发出时间校准请求并登记下一次
+    void onClockSyncTimer();
+
+    // 帧的主机对齐时间：带设备时间戳的帧按时钟估计换算，其他帧按接收时间减去单程延迟估计
+    U64 frameAlignedTime(const std::vector<U8>& frame, U32 len, const FrameTiming& timing) const;
+
+    // 单个参数写入命令
+    static std::vector<U8> paramWriteCmd(U8 index, INT16 value);
+
+    // 参数写入/重置应答的结果：收到应答且设备返回成功时为 CMD_RESULT_OK，设备返回失败时为 CMD_RESULT_REJECTED
+    static S32 paramWriteStatus(S32 status, const std::vector<U8>& frame, U32 len);
+
+    // 等待命令结果的调用者
+    struct CommandWaiter {
+        std::shared_ptr<std::promise<CommandResult>> promise; // 请求结果
+        ResponseCallback callback;                            // 可选回调
+    };
+
+    // 排队等待发出的命令
+    struct OutgoingCommand {
+        std::vector<U8> cmd;                 // 业务命令
+        CorrelationKey key;                  // 关联键，相同者合并
+        std::vector<CommandWaiter> waiters;  // 合并后的所有调用者
+    };
+
+    // 命令发送窗口（受 m_sendMutex 保护）
+    std::mutex m_sendMutex;
+    std::array<std::deque<OutgoingCommand>, COMMAND_PRIORITY_COUNT> m_sendQueues; // 各优先级等待窗口额度的命令
+    U32 m_inFlight = 0;                      // 在途命令数
+    U32 m_windowSize = CMD_WINDOW_SIZE;      // 窗口大小
+    std::atomic<U32> m_coalescedCount{0};    // 被合并掉的命令数
+
+    // 与排队中的同类命令合并，返回新命令应进入的优先级（需持有 m_sendMutex）
+    U32 coalesceLocked(OutgoingCommand& command, U32 level);
+
+    // 在窗口额度内发出排队的命令，已断开时以取消结束排队的命令
+    void pumpSendQueue();
+
+    // 编码并发出一条需要应答的命令（需持有 m_sendMutex）
+    void transmitLocked(OutgoingCommand& command);
+
+    // 请求结束：取消超时定时器，归还窗口额度
+    void onRequestCompleted(U32 requestId);
+
+    // 以取消结束所有排队的命令
+    void cancelQueuedCommands();
+
+    // 结束所有排队和在途的命令
+    void cancelPendingCommands();
 
 public slots:
     // 可以添加槽函数来响应信号
@@ -90,28 +327,50 @@ private slots:
 
 public:
     signals:
-        void thicknessValueChanged(float value);
-        void electricValueChanged(INT16 value);
+        // 最新值以及自上次发布以来的最小值、最大值和数据个数，最多每个发布间隔发出一次；
+        // 参数只用 Qt 内置类型，跨线程（排队）连接无需注册元类型
+        void thicknessValueChanged(float value, float minValue, float maxValue, int count);
+        void electricValueChanged(int value, int minValue, int maxValue, int count);
+        void dispatcherOverloaded(bool overloaded);
+        // 处理函数超预算（由报告执行器发出，只用 Qt 内置类型），durationNs 为本次执行时间
+        void handlerOverBudget(int frameType, qulonglong durationNs);
+        void waveReady();
+        void waveAudited(float deviceThickness, float hostThickness);
 
 
 private:
-    // S32 ProcThickness(const U8* frame, U32 len);
-    // S32 ProcThkCmd(const U8* frame, U32 len);
-    // S32 ProcWave(const U8* frame, U32 len);
-    // S32 ProcParam(const U8* frame, U32 len);
-    // S32 ProcElectriCmd(const U8* frame, U32 len);   
-
-    // 私有构造函数
-    EmatCommunicater();
-    ~EmatCommunicater();
+    // 帧处理函数，在本设备的帧调度器中调用
+    S32 ProcThickness(const std::vector<U8>& frame, U32 len);
+    S32 ProcThkCmd(const std::vector<U8>& frame, U32 len);
+    S32 ProcWave(const std::vector<U8>& frame, U32 len);
+    S32 ProcParam(const std::vector<U8>& frame, U32 len);
+    S32 ProcElectriCmd(const std::vector<U8>& frame, U32 len);
+    S32 ProcTimeCmd(const std::vector<U8>& frame, U32 len);   
+
     void init_device_param(DEVICE_ULTRA_PARAM_U& deviceParam);
-    bool recieveThreadRunning = false;
+    ParamCache m_paramCache; // 设备参数缓存
+    WavePool m_wavePool; // 波形发布池
+    std::mutex m_thicknessMutex; // 厚度历史互斥锁
+    MinMaxPyramid<float> m_thicknessPyramid{THICKNESS_HISTORY_CAPACITY}; // 厚度历史金字塔
+    ThicknessSeries m_thicknessSeries{THICKNESS_SERIES_CAPACITY};        // 厚度时间序列（受 m_thicknessMutex 保护）
+    ThicknessFilter m_thicknessFilter; // 厚度滤波（只在帧调度器中访问）
+    std::mutex m_filterConfigMutex;    // 待生效的滤波配置互斥锁
+    ThicknessFilterConfig m_pendingFilterConfig; // 待生效的滤波配置
+    std::atomic<bool> m_filterConfigPending{false}; // 有待生效的滤波配置
+    std::atomic<bool> m_filterResetPending{false};  // 滤波状态待清空（由帧调度器在下一个厚度数据前执行）
+    std::atomic<U64> m_rejectedThicknessCount{0};   // 离群丢弃的厚度数据数
+    EchoAnalyzer m_echoAnalyzer; // 回波分析（只在帧调度器中访问）
+    std::mutex m_echoMutex;      // 回波分析结果互斥锁
+    EchoResult m_echoResult{ECHO_RESULT_NO_ECHO}; // 最近一次回波分析结果
+    WaveAssembler m_waveAssembler{m_wavePool}; // 波形重组（只在帧调度器中访问）
+
+    // 发布重组完成的波形
+    void publishWave();
+    std::atomic<bool> recieveThreadRunning{false};
     std::thread receiveThread;
     std::unique_ptr<ICommunicator> m_communicator; // 使用抽象接口指针代替具体实现
     float thicknessValue = 0.0f; // 当前厚度值
     // 通信接口相关成员
-    bool m_isConnected = false;
+    std::atomic<bool> m_isConnected{false}; // 发送命令的线程与连接、断开的线程并发读写
     ConnectionType m_currentConnectionType = ConnectionType::SERIAL; // 当前连接类型
-    // 用于命令帧处理的缓冲区
-    FrameBuffer m_frameBuffer;
 };
\ No newline at end of file